@@ -0,0 +1,260 @@
+/*
+ * Abbreviation expansion
+ *
+ * The dictionary lives in flash as a const table. At boot it is compiled
+ * into a trie with failure links (Aho-Corasick) in a static node pool
+ * sized for it. Larger automatons (the benchmarks) get a pool from the
+ * heap, freed when the built-in dictionary is rebuilt:
+ *
+ *   child/sibling  first child and next sibling, children unsorted
+ *   fail           longest proper suffix of this node that is also a node
+ *   match          entry + 1 of the longest trigger ending here, following
+ *                  failure links, or 0
+ *
+ * abbrev_step() follows at most one child list per node visited and the
+ * failure chain is amortised O(1) per character, so per-key cost depends
+ * on the alphabet, not on the dictionary size.
+ *
+ * Matching folds letters to upper case, as the Apple II does. Control
+ * characters (arrows, Return, Delete) reset the automaton, since the
+ * Apple II side has moved the cursor and the recent characters no longer
+ * form a word.
+ *
+ * Triggers start with a backslash, which the Apple II keyboard cannot
+ * type, so ordinary typing never expands by accident. No trigger may be
+ * a prefix of another.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "abbrev.h"
+#include "config.h"
+#include "keyq.h"
+
+#define ABBREV_MAX_NODES    256     // Built-in dictionary uses about 50
+#define ABBREV_TRIGGER_MAX  16
+#define ABBREV_BACKSPACE    0x08    // Left arrow, erases in GETLN
+#define NODE_NONE           0
+
+typedef struct {
+    const char *trigger;
+    const char *expansion;
+} abbrev_entry_t;
+
+static const abbrev_entry_t dictionary[] = {
+    { "\\CL",  "CALL -151\r"  },
+    { "\\P6",  "PR#6\r"       },
+    { "\\IN6", "IN#6\r"       },
+    { "\\CAT", "CATALOG\r"    },
+    { "\\HG",  "HGR\r"        },
+    { "\\HM",  "HOME\r"       },
+    { "\\TX",  "TEXT\r"       },
+    { "\\BL",  "BLOAD "       },
+    { "\\BR",  "BRUN "        },
+    { "\\LD",  "LOAD "        },
+    { "\\SV",  "SAVE "        },
+    { "\\LS",  "LIST\r"       },
+    { "\\GT",  "GOTO "        },
+    { "\\GS",  "GOSUB "       },
+    { "\\PK",  "PEEK("        },
+    { "\\PO",  "POKE "        },
+    { "\\FR",  "FOR I = 1 TO " },
+};
+
+#define DICTIONARY_SIZE (sizeof(dictionary) / sizeof(dictionary[0]))
+
+typedef struct {
+    uint16_t child;
+    uint16_t sibling;
+    uint16_t fail;
+    uint16_t match;
+    uint8_t ch;
+} abbrev_node_t;
+
+// Node 0 is the root. 'order' is scratch for the breadth-first pass.
+static abbrev_node_t dict_nodes[ABBREV_MAX_NODES];
+static uint16_t dict_order[ABBREV_MAX_NODES];
+static abbrev_node_t *nodes = dict_nodes;
+static uint16_t *order = dict_order;
+static uint32_t max_nodes = ABBREV_MAX_NODES;
+static void *heap_pool = NULL;
+static uint16_t node_count = 0;
+static uint16_t state = 0;
+static bool dictionary_built = false;
+
+static uint8_t fold(uint8_t c) {
+    return (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+}
+
+static uint16_t find_child(uint16_t node, uint8_t c) {
+    for (uint16_t n = nodes[node].child; n != NODE_NONE; n = nodes[n].sibling) {
+        if (nodes[n].ch == c) {
+            return n;
+        }
+    }
+    return NODE_NONE;
+}
+
+static bool insert(const char *trigger, uint16_t entry) {
+    uint16_t node = 0;
+    for (const char *p = trigger; *p; p++) {
+        uint8_t c = fold((uint8_t)*p);
+        uint16_t next = find_child(node, c);
+        if (next == NODE_NONE) {
+            if (node_count >= max_nodes) {
+                return false;
+            }
+            next = node_count++;
+            nodes[next] = (abbrev_node_t){ NODE_NONE, nodes[node].child, 0, 0, c };
+            nodes[node].child = next;
+        }
+        node = next;
+    }
+    nodes[node].match = entry + 1;
+    return true;
+}
+
+// Breadth-first pass filling in failure links and inherited matches, so a
+// node's failure target is always finished before the node itself
+static void link_failures(void) {
+    uint32_t head = 0, tail = 0;
+
+    for (uint16_t n = nodes[0].child; n != NODE_NONE; n = nodes[n].sibling) {
+        nodes[n].fail = 0;
+        order[tail++] = n;
+    }
+
+    while (head < tail) {
+        uint16_t node = order[head++];
+        for (uint16_t n = nodes[node].child; n != NODE_NONE; n = nodes[n].sibling) {
+            uint16_t f = nodes[node].fail;
+            uint16_t target;
+            while ((target = find_child(f, nodes[n].ch)) == NODE_NONE && f != 0) {
+                f = nodes[f].fail;
+            }
+            nodes[n].fail = target;
+            if (nodes[n].match == 0) {
+                nodes[n].match = nodes[target].match;
+            }
+            order[tail++] = n;
+        }
+    }
+}
+
+// Switch to a pool of at least 'size' nodes
+static bool select_pool(uint32_t size) {
+    free(heap_pool);
+    heap_pool = NULL;
+    nodes = dict_nodes;
+    order = dict_order;
+    max_nodes = ABBREV_MAX_NODES;
+    if (size <= ABBREV_MAX_NODES) {
+        return true;
+    }
+
+    heap_pool = malloc(size * (sizeof(abbrev_node_t) + sizeof(uint16_t)));
+    if (!heap_pool) {
+        return false;
+    }
+    nodes = heap_pool;
+    order = (uint16_t *)(nodes + size);
+    max_nodes = size;
+    return true;
+}
+
+static void reset_pool(void) {
+    nodes[0] = (abbrev_node_t){ NODE_NONE, NODE_NONE, 0, 0, 0 };
+    node_count = 1;
+    state = 0;
+}
+
+bool abbrev_build(uint32_t count, uint32_t pool_nodes,
+                  void (*get)(uint32_t index, char *buf, size_t len)) {
+    char trigger[ABBREV_TRIGGER_MAX];
+
+    dictionary_built = false;
+    if (pool_nodes > UINT16_MAX || !select_pool(pool_nodes)) {
+        return false;
+    }
+    reset_pool();
+    for (uint32_t i = 0; i < count; i++) {
+        get(i, trigger, sizeof(trigger));
+        if (!insert(trigger, (uint16_t)i)) {
+            return false;
+        }
+    }
+    link_failures();
+    return true;
+}
+
+static void get_dictionary_trigger(uint32_t index, char *buf, size_t len) {
+    strncpy(buf, dictionary[index].trigger, len - 1);
+    buf[len - 1] = '\0';
+}
+
+void abbrev_init(void) {
+    dictionary_built = abbrev_build(DICTIONARY_SIZE, ABBREV_MAX_NODES,
+                                    get_dictionary_trigger);
+}
+
+int abbrev_step(uint8_t ascii) {
+    uint8_t c = fold(ascii);
+    if (c < 0x20 || c >= 0x7F) {
+        state = 0;
+        return -1;
+    }
+
+    uint16_t next;
+    while ((next = find_child(state, c)) == NODE_NONE && state != 0) {
+        state = nodes[state].fail;
+    }
+    state = next;
+    return (int)nodes[state].match - 1;
+}
+
+void abbrev_reset(void) {
+    state = 0;
+}
+
+bool abbrev_filter(uint8_t ascii) {
+    if (!dictionary_built) {
+        return false;
+    }
+
+    int entry = abbrev_step(ascii);
+    if (entry < 0) {
+        return false;
+    }
+    state = 0;
+
+    // The completing key is swallowed; the rest of the trigger was already
+    // sent and is erased before the expansion
+    const abbrev_entry_t *e = &dictionary[entry];
+    size_t erase = strlen(e->trigger) - 1;
+    for (size_t i = 0; i < erase; i++) {
+        keyq_push(ABBREV_BACKSPACE, config.pace_us);
+    }
+    for (const char *p = e->expansion; *p; p++) {
+        keyq_push((uint8_t)*p, config.pace_us);
+    }
+    return true;
+}
+
+void abbrev_print(void) {
+    printf("%s, %u entries, %u of %lu nodes\n", config.abbrev ? "enabled" : "disabled",
+           (unsigned)DICTIONARY_SIZE, node_count, (unsigned long)max_nodes);
+    for (unsigned i = 0; i < DICTIONARY_SIZE; i++) {
+        printf("  %-6s ", dictionary[i].trigger);
+        for (const char *p = dictionary[i].expansion; *p; p++) {
+            if (*p == '\r') {
+                printf("<CR>");
+            } else {
+                putchar(*p);
+            }
+        }
+        putchar('\n');
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef _ABBREV_H_
+#define _ABBREV_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// ---------------------------------------------------------------------------
+// Abbreviation expansion
+//
+// Watches the translated key stream for trigger strings from a fixed
+// dictionary and, when one completes, sends backspaces over the trigger
+// followed by its expansion. Matching uses an Aho-Corasick automaton, so
+// the work per key does not grow with the number of entries.
+// ---------------------------------------------------------------------------
+
+// Build the automaton for the built-in dictionary
+void abbrev_init(void);
+
+// Build an automaton from 'count' triggers produced by get(); used by the
+// benchmarks. A 'pool_nodes' above the built-in pool (ABBREV_MAX_NODES in
+// abbrev.c) is taken from the heap until abbrev_init() runs again. Returns
+// false if the pool cannot be allocated or is exhausted.
+bool abbrev_build(uint32_t count, uint32_t pool_nodes,
+                  void (*get)(uint32_t index, char *buf, size_t len));
+
+// Advance the automaton by one character; returns the index of the entry
+// whose trigger ends here, or -1
+int abbrev_step(uint8_t ascii);
+
+// Feed one translated key. Returns true if it completed a trigger and the
+// expansion has been queued in its place.
+bool abbrev_filter(uint8_t ascii);
+
+// Forget the partial match, as if no key had been typed
+void abbrev_reset(void);
+
+void abbrev_print(void);
+
+#endif
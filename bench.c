@@ -0,0 +1,232 @@
+/*
+ * Hot path micro-benchmarks
+ *
+ * SysTick is run free from the processor clock as a 24-bit down counter.
+ * Every case has an untimed setup step (e.g. resetting the previous report
+ * so a key reads as new) and a timed step; each timed call is measured on
+ * its own so the 24-bit counter cannot wrap mid-measurement. The cost of
+ * an empty timed call is measured first and subtracted.
+ *
+ * Output format, one line per case:
+ *
+ *   bench,<case>,<iterations>,<min_cycles>,<avg_cycles>,<max_cycles>,<avg_ns>
+ *
+ * process_kbd_report figures cover translation up to the output queue; the
+ * queue is drained between calls, with output muted. The output stage
+ * itself is not benchmarked: driving the bus means real STROBE pulses to
+ * the Apple II, and its time is set by the strobe_us setting (bus busy
+ * time is in the stats command).
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#include "abbrev.h"
+#include "bench.h"
+#include "keyboard.h"
+#include "keyq.h"
+
+#define BENCH_ITERATIONS   1000
+#define SYSTICK_MASK       0x00FFFFFF
+#define BENCH_ABBREV_NODES 4096    // 1000 synthetic triggers; heap, during the run only
+
+typedef struct {
+    const char *name;
+    void (*setup)(void);
+    void (*run)(void);
+} bench_case_t;
+
+static hid_keyboard_report_t report_empty;
+static hid_keyboard_report_t report_one;
+static hid_keyboard_report_t report_six;
+static hid_keyboard_report_t report_shift;
+static volatile uint8_t sink;
+
+static void setup_none(void) {}
+static void run_none(void) {}
+
+static void run_hid_to_ascii(void) {
+    sink = hid_to_ascii(HID_KEY_A, KEYBOARD_MODIFIER_LEFTSHIFT);
+}
+
+static void run_is_new_key(void) {
+    // Worst case: not present, all six slots compared
+    sink = is_new_key(HID_KEY_Z, &report_six);
+}
+
+static void setup_clean(void) {
+    keyq_drain();
+    keyboard_reset_state();
+}
+
+static void setup_held_six(void) {
+    setup_clean();
+    process_kbd_report(&report_six);
+    keyq_drain();
+}
+
+static void run_report_empty(void) {
+    process_kbd_report(&report_empty);
+}
+
+static void run_report_one(void) {
+    process_kbd_report(&report_one);
+}
+
+static void run_report_six(void) {
+    process_kbd_report(&report_six);
+}
+
+static void run_report_modifier_only(void) {
+    process_kbd_report(&report_shift);
+}
+
+static const bench_case_t cases[] = {
+    { "hid_to_ascii",              setup_none,     run_hid_to_ascii         },
+    { "is_new_key",                setup_none,     run_is_new_key           },
+    { "process_kbd_report_empty",  setup_clean,    run_report_empty         },
+    { "process_kbd_report_1key",   setup_clean,    run_report_one           },
+    { "process_kbd_report_6key",   setup_clean,    run_report_six           },
+    { "process_kbd_report_modonly", setup_held_six, run_report_modifier_only },
+    { "process_kbd_report_dup",    setup_held_six, run_report_six           },
+};
+
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+} bench_result_t;
+
+static void measure(const bench_case_t *c, bench_result_t *r) {
+    r->min = UINT32_MAX;
+    r->max = 0;
+    r->total = 0;
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        c->setup();
+        uint32_t start = systick_hw->cvr;
+        c->run();
+        uint32_t cycles = (start - systick_hw->cvr) & SYSTICK_MASK;
+
+        if (cycles < r->min) r->min = cycles;
+        if (cycles > r->max) r->max = cycles;
+        r->total += cycles;
+    }
+}
+
+static void print_result(const char *name, bench_result_t *r,
+                         uint32_t overhead, uint32_t hz) {
+    uint32_t avg = (uint32_t)(r->total / BENCH_ITERATIONS);
+    avg    = avg    > overhead ? avg    - overhead : 0;
+    r->min = r->min > overhead ? r->min - overhead : 0;
+    r->max = r->max > overhead ? r->max - overhead : 0;
+
+    printf("bench,%s,%d,%lu,%lu,%lu,%lu\n", name, BENCH_ITERATIONS,
+           (unsigned long)r->min, (unsigned long)avg, (unsigned long)r->max,
+           (unsigned long)((uint64_t)avg * 1000000000u / hz));
+}
+
+// Synthetic trigger for entry 'index': 3-6 upper case letters derived
+// from the index, so the same dictionary is built on every run
+static void synthetic_trigger(uint32_t index, char *buf, size_t len) {
+    uint32_t x = index * 2654435761u + 1;
+    size_t n = 3 + (x >> 28) % 4;
+    if (n > len - 1) {
+        n = len - 1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        buf[i] = 'A' + x % 26;
+    }
+    buf[n] = '\0';
+}
+
+static uint32_t stream_rng;
+
+static void run_abbrev_step(void) {
+    stream_rng ^= stream_rng << 13;
+    stream_rng ^= stream_rng >> 17;
+    stream_rng ^= stream_rng << 5;
+    sink = (uint8_t)abbrev_step('A' + stream_rng % 26);
+}
+
+// Per-key matching cost against dictionaries of increasing size
+static void bench_abbrev(uint32_t overhead, uint32_t hz) {
+    static const uint32_t sizes[] = { 10, 100, 1000 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        char name[24];
+        snprintf(name, sizeof(name), "abbrev_step_%lu", (unsigned long)sizes[i]);
+        if (!abbrev_build(sizes[i], BENCH_ABBREV_NODES, synthetic_trigger)) {
+            printf("bench,%s,0,0,0,0,0\n", name);
+            continue;
+        }
+
+        stream_rng = 12345;
+        bench_case_t c = { name, setup_none, run_abbrev_step };
+        bench_result_t r;
+        measure(&c, &r);
+        print_result(name, &r, overhead, hz);
+    }
+
+    // Back to the real dictionary
+    abbrev_init();
+}
+
+void bench_run(void) {
+    static const bench_case_t empty = { "overhead", setup_none, run_none };
+
+    memset(&report_empty, 0, sizeof(report_empty));
+    memset(&report_one, 0, sizeof(report_one));
+    report_one.keycode[0] = HID_KEY_A;
+    report_six = report_empty;
+    for (int i = 0; i < 6; i++) {
+        report_six.keycode[i] = HID_KEY_A + i;
+    }
+    report_shift = report_six;
+    report_shift.modifier = KEYBOARD_MODIFIER_LEFTSHIFT;
+
+    // Free-running 24-bit down counter clocked from the processor
+    uint32_t saved_csr = systick_hw->csr;
+    uint32_t saved_rvr = systick_hw->rvr;
+    systick_hw->csr = 0;
+    systick_hw->rvr = SYSTICK_MASK;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5;  // ENABLE | CLKSOURCE=processor
+
+    keyboard_profile_t saved_profile = keyboard_get_profile();
+    keyboard_set_profile(PROFILE_NORMAL);
+    output_set_muted(true);
+
+    bench_result_t overhead;
+    measure(&empty, &overhead);
+
+    uint32_t hz = clock_get_hz(clk_sys);
+    printf("bench,clock_hz,%lu\n", (unsigned long)hz);
+    printf("bench,overhead,%d,%lu,%lu,%lu,0\n", BENCH_ITERATIONS,
+           (unsigned long)overhead.min,
+           (unsigned long)(overhead.total / BENCH_ITERATIONS),
+           (unsigned long)overhead.max);
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        bench_result_t r;
+        measure(&cases[i], &r);
+        print_result(cases[i].name, &r, overhead.min, hz);
+    }
+    bench_abbrev(overhead.min, hz);
+
+    keyq_drain();
+    output_set_muted(false);
+    keyboard_reset_state();
+    keyboard_set_profile(saved_profile);
+
+    systick_hw->csr = 0;
+    systick_hw->rvr = saved_rvr;
+    systick_hw->cvr = 0;
+    systick_hw->csr = saved_csr;
+}
@@ -0,0 +1,12 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+// ---------------------------------------------------------------------------
+// Hot path micro-benchmarks
+//
+// Times the keystroke path in CPU cycles using the SysTick counter and
+// prints one CSV line per case, so results can be diffed across commits.
+// ---------------------------------------------------------------------------
+void bench_run(void);
+
+#endif
@@ -0,0 +1,166 @@
+/*
+ * Bus waveform trace
+ *
+ * Samples are only stored when the packed pin state differs from the last
+ * one, so idle periods and repeated SHIFT writes cost nothing but a compare.
+ * The ring keeps the most recent BUS_TRACE_DEPTH transitions.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "bus_trace.h"
+
+#define BUS_TRACE_DEPTH   512   // Power of two
+
+static bus_trace_entry_t ring[BUS_TRACE_DEPTH];
+static uint32_t head = 0;       // Total samples recorded
+static uint16_t last_sample = 0;
+
+// Timing checker state
+static uint32_t data_change_us = 0;
+static uint32_t strobe_rise_us = 0;
+static uint32_t strobe_fall_us = 0;
+
+static struct {
+    uint32_t setup_violations;
+    uint32_t strobe_violations;
+    uint32_t hold_violations;
+    uint32_t min_setup_us;
+    uint32_t min_strobe_us;
+    uint32_t min_hold_us;
+} timing = { 0, 0, 0, UINT32_MAX, UINT32_MAX, UINT32_MAX };
+
+static void check_timing(uint32_t now, uint16_t prev, uint16_t sample) {
+    uint16_t changed = prev ^ sample;
+
+    if (changed & BUS_TRACE_DATA_MASK) {
+        // Data must not move while STROBE is high or too soon after it fell
+        uint32_t hold = (prev & BUS_TRACE_STROBE) ? 0 : now - strobe_fall_us;
+        if (hold < timing.min_hold_us) {
+            timing.min_hold_us = hold;
+        }
+        if (hold < BUS_MIN_HOLD_US) {
+            timing.hold_violations++;
+        }
+        data_change_us = now;
+    }
+
+    if (changed & BUS_TRACE_STROBE) {
+        if (sample & BUS_TRACE_STROBE) {
+            uint32_t setup = now - data_change_us;
+            if (setup < timing.min_setup_us) {
+                timing.min_setup_us = setup;
+            }
+            if (setup < BUS_MIN_SETUP_US) {
+                timing.setup_violations++;
+            }
+            strobe_rise_us = now;
+        } else {
+            uint32_t width = now - strobe_rise_us;
+            if (width < timing.min_strobe_us) {
+                timing.min_strobe_us = width;
+            }
+            if (width < BUS_MIN_STROBE_US) {
+                timing.strobe_violations++;
+            }
+            strobe_fall_us = now;
+        }
+    }
+}
+
+void bus_trace_record(uint16_t sample) {
+    if (sample == last_sample) {
+        return;
+    }
+
+    uint32_t now = time_us_32();
+    check_timing(now, last_sample, sample);
+
+    bus_trace_entry_t *e = &ring[head & (BUS_TRACE_DEPTH - 1)];
+    e->time_us = now;
+    e->sample = sample;
+    head++;
+    last_sample = sample;
+}
+
+void bus_trace_clear(void) {
+    head = 0;
+    timing.setup_violations = 0;
+    timing.strobe_violations = 0;
+    timing.hold_violations = 0;
+    timing.min_setup_us = UINT32_MAX;
+    timing.min_strobe_us = UINT32_MAX;
+    timing.min_hold_us = UINT32_MAX;
+}
+
+static void print_min(const char *name, uint32_t value, uint32_t limit,
+                      uint32_t violations) {
+    if (value == UINT32_MAX) {
+        printf("%-7s      -  (min %lu us)\n", name, (unsigned long)limit);
+    } else {
+        printf("%-7s %6lu us (min %lu us) violations=%lu\n", name,
+               (unsigned long)value, (unsigned long)limit,
+               (unsigned long)violations);
+    }
+}
+
+uint32_t bus_trace_latest(bus_trace_entry_t *out, uint32_t n) {
+    uint32_t count = head < BUS_TRACE_DEPTH ? head : BUS_TRACE_DEPTH;
+    if (n > count) {
+        n = count;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = ring[(head - n + i) & (BUS_TRACE_DEPTH - 1)];
+    }
+    return n;
+}
+
+uint32_t bus_trace_violations(void) {
+    return timing.setup_violations + timing.strobe_violations + timing.hold_violations;
+}
+
+void bus_trace_print_timing(void) {
+    printf("transitions %lu\n", (unsigned long)head);
+    print_min("setup",  timing.min_setup_us,  BUS_MIN_SETUP_US,  timing.setup_violations);
+    print_min("strobe", timing.min_strobe_us, BUS_MIN_STROBE_US, timing.strobe_violations);
+    print_min("hold",   timing.min_hold_us,   BUS_MIN_HOLD_US,   timing.hold_violations);
+}
+
+static void print_vcd_sample(uint16_t sample) {
+    putchar('b');
+    for (int bit = 6; bit >= 0; bit--) {
+        putchar((sample >> bit) & 1 ? '1' : '0');
+    }
+    printf(" d\n%cs\n%cr\n%ck\n",
+           (sample & BUS_TRACE_STROBE) ? '1' : '0',
+           (sample & BUS_TRACE_RESET)  ? '1' : '0',
+           (sample & BUS_TRACE_SHIFT)  ? '1' : '0');
+}
+
+void bus_trace_dump_vcd(void) {
+    uint32_t count = head < BUS_TRACE_DEPTH ? head : BUS_TRACE_DEPTH;
+    uint32_t first = head - count;
+
+    printf("$timescale 1us $end\n");
+    printf("$scope module apple2_keyboard $end\n");
+    printf("$var wire 7 d data $end\n");
+    printf("$var wire 1 s strobe $end\n");
+    printf("$var wire 1 r reset $end\n");
+    printf("$var wire 1 k shift $end\n");
+    printf("$upscope $end\n");
+    printf("$enddefinitions $end\n");
+
+    if (count == 0) {
+        return;
+    }
+
+    // Times are relative to the oldest sample still in the ring
+    uint32_t t0 = ring[first & (BUS_TRACE_DEPTH - 1)].time_us;
+    for (uint32_t i = first; i < head; i++) {
+        const bus_trace_entry_t *e = &ring[i & (BUS_TRACE_DEPTH - 1)];
+        printf("#%lu\n", (unsigned long)(e->time_us - t0));
+        print_vcd_sample(e->sample);
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef _BUS_TRACE_H_
+#define _BUS_TRACE_H_
+
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Bus waveform trace
+//
+// Every change of the Apple II side pins is recorded with a microsecond
+// timestamp in a RAM ring, checked against minimum timing, and can be
+// dumped as a VCD file for GTKWave.
+//
+// A sample packs the bus into 10 bits: D0-D6, then STROBE, RESET, SHIFT.
+//
+// Records come from the real pin writes in main.c, which need the SDK. The
+// host build (tools/host) runs the checker and VCD export on synthetic
+// waveforms only.
+// ---------------------------------------------------------------------------
+#define BUS_TRACE_DATA_MASK    0x07F
+#define BUS_TRACE_STROBE       (1u << 7)
+#define BUS_TRACE_RESET        (1u << 8)
+#define BUS_TRACE_SHIFT        (1u << 9)
+
+// Minimum timing asserted on every transition
+#define BUS_MIN_SETUP_US       1       // Data stable before STROBE rises
+#define BUS_MIN_STROBE_US      90      // STROBE high time
+#define BUS_MIN_HOLD_US        1       // Data stable after STROBE falls
+
+typedef struct {
+    uint32_t time_us;
+    uint16_t sample;
+} bus_trace_entry_t;
+
+void bus_trace_record(uint16_t sample);
+
+// Copy up to 'n' of the most recent samples, oldest first. Touches only
+// the ring, so it is safe from fault handlers.
+uint32_t bus_trace_latest(bus_trace_entry_t *out, uint32_t n);
+void bus_trace_print_timing(void);
+
+// Setup, STROBE and hold violations since the last clear
+uint32_t bus_trace_violations(void);
+void bus_trace_dump_vcd(void);
+void bus_trace_clear(void);
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * Control codes and compose sequences
+ *
+ * Compose sequences are declared as strings in sequences[] and compiled at
+ * boot into a transition table indexed by [state][character], so each key
+ * of a sequence costs one table load. State 0 means no sequence is in
+ * progress (the only state plain keys ever see), state 1 is the start of
+ * a sequence. A character with no transition abandons the sequence and is
+ * swallowed.
+ *
+ * Letters are folded to upper case, so "esc" and "ESC" are the same.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "compose.h"
+
+#define COMPOSE_MAX_STATES   48
+#define COMPOSE_IDLE         0
+#define COMPOSE_START        1
+
+// clang-format off
+const uint8_t ctrl_code[128] = {
+    ['@'] = KEY_CODE_NUL,
+    ['a'] = 0x01, ['b'] = 0x02, ['c'] = 0x03, ['d'] = 0x04, ['e'] = 0x05,
+    ['f'] = 0x06, ['g'] = 0x07, ['h'] = 0x08, ['i'] = 0x09, ['j'] = 0x0A,
+    ['k'] = 0x0B, ['l'] = 0x0C, ['m'] = 0x0D, ['n'] = 0x0E, ['o'] = 0x0F,
+    ['p'] = 0x10, ['q'] = 0x11, ['r'] = 0x12, ['s'] = 0x13, ['t'] = 0x14,
+    ['u'] = 0x15, ['v'] = 0x16, ['w'] = 0x17, ['x'] = 0x18, ['y'] = 0x19,
+    ['z'] = 0x1A,
+    ['A'] = 0x01, ['B'] = 0x02, ['C'] = 0x03, ['D'] = 0x04, ['E'] = 0x05,
+    ['F'] = 0x06, ['G'] = 0x07, ['H'] = 0x08, ['I'] = 0x09, ['J'] = 0x0A,
+    ['K'] = 0x0B, ['L'] = 0x0C, ['M'] = 0x0D, ['N'] = 0x0E, ['O'] = 0x0F,
+    ['P'] = 0x10, ['Q'] = 0x11, ['R'] = 0x12, ['S'] = 0x13, ['T'] = 0x14,
+    ['U'] = 0x15, ['V'] = 0x16, ['W'] = 0x17, ['X'] = 0x18, ['Y'] = 0x19,
+    ['Z'] = 0x1A,
+    ['['] = 0x1B, ['\\'] = 0x1C, [']'] = 0x1D, ['^'] = 0x1E, ['_'] = 0x1F,
+};
+// clang-format on
+
+typedef struct {
+    const char *keys;   // Keys typed after Menu
+    uint8_t code;
+} compose_sequence_t;
+
+static const compose_sequence_t sequences[] = {
+    // Dead-key style: Menu then the character Ctrl would combine with
+    { "@",   KEY_CODE_NUL },
+    { "[",   0x1B },
+    { "\\",  0x1C },
+    { "]",   0x1D },
+    { "^",   0x1E },
+    { "_",   0x1F },
+    // ASCII mnemonics
+    { "NUL", KEY_CODE_NUL },
+    { "BEL", 0x07 },
+    { "BS",  0x08 },
+    { "HT",  0x09 },
+    { "LF",  0x0A },
+    { "VT",  0x0B },
+    { "FF",  0x0C },
+    { "CR",  0x0D },
+    { "ESC", 0x1B },
+    { "FS",  0x1C },
+    { "GS",  0x1D },
+    { "RS",  0x1E },
+    { "US",  0x1F },
+    { "DEL", 0x7F },
+};
+
+#define SEQUENCE_COUNT (sizeof(sequences) / sizeof(sequences[0]))
+
+uint8_t compose_state = COMPOSE_IDLE;
+
+static uint8_t transitions[COMPOSE_MAX_STATES][128];
+static uint8_t output[COMPOSE_MAX_STATES];   // Code emitted on reaching state
+static uint8_t state_count = 0;
+
+static uint8_t fold(uint8_t c) {
+    return (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+}
+
+void compose_init(void) {
+    memset(transitions, 0, sizeof(transitions));
+    memset(output, 0, sizeof(output));
+    state_count = COMPOSE_START + 1;
+
+    for (unsigned i = 0; i < SEQUENCE_COUNT; i++) {
+        uint8_t s = COMPOSE_START;
+        const char *p;
+        for (p = sequences[i].keys; *p; p++) {
+            uint8_t c = fold((uint8_t)*p) & 0x7F;
+            if (transitions[s][c] == 0) {
+                if (state_count >= COMPOSE_MAX_STATES) {
+                    printf("Compose: too many states, '%s' dropped\n",
+                           sequences[i].keys);
+                    break;
+                }
+                transitions[s][c] = state_count++;
+            }
+            s = transitions[s][c];
+        }
+        // A dropped sequence stops on a prefix other sequences share
+        if (*p == '\0') {
+            output[s] = sequences[i].code;
+        }
+    }
+}
+
+void compose_start(void) {
+    compose_state = COMPOSE_START;
+}
+
+void compose_reset(void) {
+    compose_state = COMPOSE_IDLE;
+}
+
+uint8_t compose_feed(uint8_t ascii) {
+    uint8_t next = transitions[compose_state][fold(ascii) & 0x7F];
+    if (next == 0) {
+        compose_state = COMPOSE_IDLE;
+        return 0;
+    }
+    if (output[next]) {
+        compose_state = COMPOSE_IDLE;
+        return output[next];
+    }
+    compose_state = next;
+    return 0;
+}
+
+void compose_print(void) {
+    for (unsigned i = 0; i < SEQUENCE_COUNT; i++) {
+        uint8_t code = sequences[i].code == KEY_CODE_NUL ? 0 : sequences[i].code;
+        printf("  Menu %-4s -> 0x%02X\n", sequences[i].keys, code);
+    }
+    printf("%u states\n", state_count);
+}
@@ -0,0 +1,41 @@
+#ifndef _COMPOSE_H_
+#define _COMPOSE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------
+// Control codes and compose sequences
+//
+// ctrl_code[] gives the character Ctrl turns each 7-bit character into
+// (0 = unchanged): letters give 0x01-0x1A and @ [ \ ] ^ _ give 0x00 and
+// 0x1B-0x1F, as on the Apple II keyboard.
+//
+// Pressing the Menu (Application) key starts a compose sequence: the next
+// key, or a short mnemonic such as ESC or NUL, produces a control code
+// that may be awkward to type otherwise.
+// ---------------------------------------------------------------------------
+
+// Ctrl-@ (NUL) is carried internally as 0x80, since 0 means "no key".
+// Outputs send only the low 7 bits (D0-D6 on the bus), so it goes out as
+// 0x00.
+#define KEY_CODE_NUL   0x80
+
+extern const uint8_t ctrl_code[128];
+
+// Non-zero while a compose sequence is in progress
+extern uint8_t compose_state;
+
+void compose_init(void);
+void compose_start(void);
+
+// Abandon any sequence in progress
+void compose_reset(void);
+
+// Feed a translated key to the compose sequence in progress. Returns the
+// key to emit, or 0 while the sequence is incomplete or was abandoned.
+uint8_t compose_feed(uint8_t ascii);
+
+void compose_print(void);
+
+#endif
@@ -0,0 +1,472 @@
+/*
+ * Persistent configuration store
+ *
+ * CONFIG_SECTORS flash sectors at the end of flash are used in rotation.
+ * Exactly one is active: it starts with a header carrying a sequence
+ * number, followed by records appended in write order:
+ *
+ *   +--------+--------+------------+----------------------+
+ *   | key 16 | len 16 | crc32 32   | data, padded to 4    |
+ *   +--------+--------+------------+----------------------+
+ *
+ * Erased flash reads 0xFF, so a key of 0xFFFF marks the end of the log.
+ * A record whose CRC does not match (power lost mid-write) ends the log
+ * as well. A later record for the same key supersedes earlier ones and a
+ * zero-length record deletes the key.
+ *
+ * When the active sector fills up, the latest copy of every live key is
+ * copied into the next sector in the rotation, which then becomes active.
+ * Rotating through all sectors spreads erases evenly (wear leveling). The
+ * new sector's first page, which holds the header, is programmed last, so
+ * an interrupted compaction leaves the old sector in charge.
+ *
+ * config_load() walks the active sector once, checking each CRC, and
+ * builds an index of the latest record for every key. Lookups and
+ * compaction go through the index and never rescan the log. A sector
+ * holds at most CONFIG_INDEX_MAX records, so the index cannot overflow.
+ *
+ * Flash erase and program stall XIP, so they are never run from a USB
+ * callback. Writes are staged in RAM and flushed by config_task(), and an
+ * erase is only started once no keyboard, gamepad or mouse report has
+ * been seen for CONFIG_ERASE_IDLE_MS.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "config.h"
+#include "looptrace.h"
+#include "stats.h"
+
+#define CONFIG_SECTORS        4
+#define CONFIG_REGION_SIZE    (CONFIG_SECTORS * FLASH_SECTOR_SIZE)
+#define CONFIG_REGION_OFFSET  (PICO_FLASH_SIZE_BYTES - CONFIG_REGION_SIZE)
+#define CONFIG_MAGIC          0x46434253u   // "SBCF"
+#define CONFIG_KEY_END        0xFFFF
+#define CONFIG_STAGE_SIZE     1024
+#define CONFIG_ERASE_IDLE_MS  100
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t seq_inv;
+    uint32_t reserved;
+} config_sector_header_t;
+
+typedef struct {
+    uint16_t key;
+    uint16_t len;
+    uint32_t crc;
+} config_record_header_t;
+
+#define RECORD_SIZE(len)  (sizeof(config_record_header_t) + (((len) + 3u) & ~3u))
+
+#define CONFIG_INDEX_MAX  ((FLASH_SECTOR_SIZE - sizeof(config_sector_header_t)) / \
+                           sizeof(config_record_header_t))
+
+// Latest record of a key in the active sector; sorted by key
+typedef struct {
+    uint16_t key;
+    uint16_t offset;
+} config_index_t;
+
+config_t config = {
+    .strobe_us    = STROBE_DURATION_US,
+    .reset_ms     = RESET_DURATION_MS,
+    .led_blink_ms = LED_BLINK_MS,
+    .layout       = LAYOUT_DEFAULT,
+    .pace_us      = PACE_US,
+    .macro_timed  = 0,
+    .abbrev       = 0,
+    .outputs      = OUTPUT_BUS,
+    .serial_baud  = SERIAL_BAUD,
+};
+
+static int active_sector = -1;       // -1: store empty/unformatted
+static uint32_t active_seq = 0;
+static uint32_t write_offset = 0;    // Next free byte within active sector
+
+static config_index_t key_index[CONFIG_INDEX_MAX];
+static uint32_t index_count = 0;
+
+static uint8_t stage[CONFIG_STAGE_SIZE];
+static uint32_t stage_len = 0;
+static uint32_t last_report_count = 0;
+static uint32_t idle_since_ms = 0;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static uint32_t crc32(uint32_t crc, const uint8_t *data, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t record_crc(uint16_t key, uint16_t len, const uint8_t *data) {
+    uint16_t kl[2] = { key, len };
+    return crc32(crc32(0, (const uint8_t *)kl, sizeof(kl)), data, len);
+}
+
+static const uint8_t *sector_ptr(int sector) {
+    return (const uint8_t *)(uintptr_t)(XIP_BASE + CONFIG_REGION_OFFSET +
+                             sector * FLASH_SECTOR_SIZE);
+}
+
+static uint32_t sector_offset(int sector) {
+    return CONFIG_REGION_OFFSET + sector * FLASH_SECTOR_SIZE;
+}
+
+static bool sector_header_valid(int sector, uint32_t *seq) {
+    const config_sector_header_t *h = (const config_sector_header_t *)sector_ptr(sector);
+    if (h->magic != CONFIG_MAGIC || h->seq != ~h->seq_inv) {
+        return false;
+    }
+    *seq = h->seq;
+    return true;
+}
+
+// Walk the records of a sector. Returns the offset just past the last
+// valid record. fn may be NULL.
+static uint32_t walk_sector(int sector,
+                            void (*fn)(uint32_t offset, const config_record_header_t *r,
+                                       const uint8_t *data)) {
+    const uint8_t *base = sector_ptr(sector);
+    uint32_t offset = sizeof(config_sector_header_t);
+
+    while (offset + sizeof(config_record_header_t) <= FLASH_SECTOR_SIZE) {
+        const config_record_header_t *r = (const config_record_header_t *)(base + offset);
+        if (r->key == CONFIG_KEY_END || r->len > CONFIG_VALUE_MAX ||
+            offset + RECORD_SIZE(r->len) > FLASH_SECTOR_SIZE) {
+            break;
+        }
+        const uint8_t *data = base + offset + sizeof(*r);
+        if (record_crc(r->key, r->len, data) != r->crc) {
+            break;
+        }
+        if (fn) {
+            fn(offset, r, data);
+        }
+        offset += RECORD_SIZE(r->len);
+    }
+    return offset;
+}
+
+// ---------------------------------------------------------------------------
+// Index
+// ---------------------------------------------------------------------------
+
+// Position of 'key' in the index, or where it would be inserted
+static uint32_t index_find(uint16_t key) {
+    uint32_t lo = 0, hi = index_count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (key_index[mid].key < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Record 'key' as living at 'offset' in the active sector
+static void index_note(uint16_t key, uint32_t offset) {
+    uint32_t i = index_find(key);
+    if (i == index_count || key_index[i].key != key) {
+        if (index_count == CONFIG_INDEX_MAX) {
+            return;
+        }
+        memmove(&key_index[i + 1], &key_index[i], (index_count - i) * sizeof(key_index[0]));
+        index_count++;
+        key_index[i].key = key;
+    }
+    key_index[i].offset = (uint16_t)offset;
+}
+
+static const config_record_header_t *index_record(uint32_t i) {
+    return (const config_record_header_t *)(sector_ptr(active_sector) + key_index[i].offset);
+}
+
+// ---------------------------------------------------------------------------
+// Scalar settings
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const char *name;
+    uint16_t key;
+    uint32_t *value;
+    uint32_t min;
+    uint32_t max;
+} config_scalar_t;
+
+static const config_scalar_t scalars[] = {
+    { "strobe_us", CONFIG_KEY_STROBE_US,    &config.strobe_us,    1,  1000  },
+    { "reset_ms",  CONFIG_KEY_RESET_MS,     &config.reset_ms,     1,  2000  },
+    { "led_ms",    CONFIG_KEY_LED_BLINK_MS, &config.led_blink_ms, 10, 5000  },
+    { "layout",    CONFIG_KEY_LAYOUT,       &config.layout,       0,  LAYOUT_COUNT - 1 },
+    { "pace_us",   CONFIG_KEY_PACE_US,      &config.pace_us,      0,  1000000 },
+    { "macro_timed", CONFIG_KEY_MACRO_TIMED, &config.macro_timed, 0,  1     },
+    { "abbrev",    CONFIG_KEY_ABBREV,       &config.abbrev,       0,  1     },
+    { "outputs",   CONFIG_KEY_OUTPUTS,      &config.outputs,      1,  OUTPUT_ALL },
+    { "serial_baud", CONFIG_KEY_SERIAL_BAUD, &config.serial_baud, 300, 921600 },
+};
+
+#define SCALAR_COUNT (sizeof(scalars) / sizeof(scalars[0]))
+
+static const config_scalar_t *find_scalar(uint16_t key) {
+    for (unsigned i = 0; i < SCALAR_COUNT; i++) {
+        if (scalars[i].key == key) {
+            return &scalars[i];
+        }
+    }
+    return NULL;
+}
+
+static void load_record(uint32_t offset, const config_record_header_t *r,
+                        const uint8_t *data) {
+    index_note(r->key, offset);
+
+    // Scalars are applied in log order, so the latest copy wins
+    const config_scalar_t *s = find_scalar(r->key);
+    if (s && r->len == sizeof(uint32_t)) {
+        uint32_t v;
+        memcpy(&v, data, sizeof(v));
+        if (v >= s->min && v <= s->max) {
+            *s->value = v;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Load
+// ---------------------------------------------------------------------------
+
+void config_load(void) {
+    uint32_t start = time_us_32();
+
+    active_sector = -1;
+    index_count = 0;
+    for (int i = 0; i < CONFIG_SECTORS; i++) {
+        uint32_t seq;
+        if (sector_header_valid(i, &seq) &&
+            (active_sector < 0 || (int32_t)(seq - active_seq) > 0)) {
+            active_sector = i;
+            active_seq = seq;
+        }
+    }
+
+    if (active_sector >= 0) {
+        write_offset = walk_sector(active_sector, load_record);
+    }
+
+    printf("Config: %s, loaded in %lu us\n",
+           active_sector >= 0 ? "restored" : "defaults",
+           (unsigned long)(time_us_32() - start));
+}
+
+void config_for_each(uint16_t lo, uint16_t hi,
+                     void (*fn)(uint16_t key, const uint8_t *data, uint16_t len)) {
+    if (active_sector < 0) {
+        return;
+    }
+
+    for (uint32_t i = index_find(lo); i < index_count && key_index[i].key <= hi; i++) {
+        const config_record_header_t *r = index_record(i);
+        if (r->len > 0) {
+            fn(r->key, (const uint8_t *)(r + 1), r->len);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Write staging
+// ---------------------------------------------------------------------------
+
+bool config_write(uint16_t key, const void *data, uint16_t len) {
+    if (key == CONFIG_KEY_END || len > CONFIG_VALUE_MAX ||
+        stage_len + RECORD_SIZE(len) > CONFIG_STAGE_SIZE) {
+        return false;
+    }
+
+    config_record_header_t h = { key, len, record_crc(key, len, data) };
+    memcpy(&stage[stage_len], &h, sizeof(h));
+    memcpy(&stage[stage_len + sizeof(h)], data, len);
+    memset(&stage[stage_len + sizeof(h) + len], 0xFF,
+           RECORD_SIZE(len) - sizeof(h) - len);
+    stage_len += RECORD_SIZE(len);
+    return true;
+}
+
+bool config_set(uint16_t key, uint32_t value) {
+    const config_scalar_t *s = find_scalar(key);
+    if (!s || value < s->min || value > s->max) {
+        return false;
+    }
+    if (*s->value == value) {
+        return true;
+    }
+    *s->value = value;
+    return config_write(key, &value, sizeof(value));
+}
+
+// ---------------------------------------------------------------------------
+// Flash writes
+// ---------------------------------------------------------------------------
+
+// Program 'len' bytes at 'offset' within 'sector', page by page. Bytes of a
+// page outside the range are rewritten with their current contents, which
+// leaves them unchanged.
+static void program_bytes(int sector, uint32_t offset, const uint8_t *data,
+                          uint32_t len) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    const uint8_t *base = sector_ptr(sector);
+
+    while (len) {
+        uint32_t page_start = offset & ~(FLASH_PAGE_SIZE - 1);
+        uint32_t in_page = offset - page_start;
+        uint32_t n = FLASH_PAGE_SIZE - in_page;
+        if (n > len) {
+            n = len;
+        }
+
+        memcpy(page, base + page_start, FLASH_PAGE_SIZE);
+        memcpy(page + in_page, data, n);
+
+        uint32_t irq = save_and_disable_interrupts();
+        flash_range_program(sector_offset(sector) + page_start, page, FLASH_PAGE_SIZE);
+        restore_interrupts(irq);
+
+        offset += n;
+        data += n;
+        len -= n;
+    }
+}
+
+static void erase_sector(int sector) {
+    LOOPTRACE_HERE();
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(sector_offset(sector), FLASH_SECTOR_SIZE);
+    restore_interrupts(irq);
+}
+
+// Copy live records from the active sector into the next one and make it
+// active. The new header page is programmed last.
+static void compact(void) {
+    static uint8_t first_page[FLASH_PAGE_SIZE];
+    int next = active_sector < 0 ? 0 : (active_sector + 1) % CONFIG_SECTORS;
+    uint32_t seq = active_seq + 1;
+
+    erase_sector(next);
+
+    memset(first_page, 0xFF, sizeof(first_page));
+    config_sector_header_t h = { CONFIG_MAGIC, seq, ~seq, 0xFFFFFFFF };
+    memcpy(first_page, &h, sizeof(h));
+    uint32_t out = sizeof(h);
+
+    // Live keys are copied in key order; the index is rewritten in place
+    // with their new offsets, dropping deleted keys
+    uint32_t kept = 0;
+    if (active_sector >= 0) {
+        for (uint32_t n = 0; n < index_count; n++) {
+            const uint8_t *src = (const uint8_t *)index_record(n);
+            uint32_t len = ((const config_record_header_t *)src)->len;
+            uint32_t size = RECORD_SIZE(len);
+            if (len == 0) {
+                continue;
+            }
+            // Bytes landing in the first page are held back with the header
+            uint32_t i = 0;
+            for (; i < size && out + i < FLASH_PAGE_SIZE; i++) {
+                first_page[out + i] = src[i];
+            }
+            if (i < size) {
+                program_bytes(next, out + i, src + i, size - i);
+            }
+            key_index[kept].key = key_index[n].key;
+            key_index[kept].offset = (uint16_t)out;
+            kept++;
+            out += size;
+        }
+    }
+    index_count = kept;
+
+    program_bytes(next, 0, first_page, FLASH_PAGE_SIZE);
+
+    active_sector = next;
+    active_seq = seq;
+    write_offset = out;
+}
+
+void config_task(void) {
+    if (stage_len == 0) {
+        return;
+    }
+
+    // Track input activity so erases wait for a quiet moment
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    uint32_t reports = stats_total.reports + stats_total.pad_reports;
+    if (reports != last_report_count) {
+        last_report_count = reports;
+        idle_since_ms = now;
+    }
+
+    if (active_sector < 0 || write_offset + stage_len > FLASH_SECTOR_SIZE) {
+        if (now - idle_since_ms < CONFIG_ERASE_IDLE_MS) {
+            return;
+        }
+        compact();
+        if (write_offset + stage_len > FLASH_SECTOR_SIZE) {
+            printf("Config: store full, %lu bytes not saved\n",
+                   (unsigned long)stage_len);
+            stage_len = 0;
+            return;
+        }
+    }
+
+    program_bytes(active_sector, write_offset, stage, stage_len);
+    for (uint32_t pos = 0; pos < stage_len;) {
+        config_record_header_t r;
+        memcpy(&r, &stage[pos], sizeof(r));
+        index_note(r.key, write_offset + pos);
+        pos += RECORD_SIZE(r.len);
+    }
+    write_offset += stage_len;
+    stage_len = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Console
+// ---------------------------------------------------------------------------
+
+void config_print(void) {
+    for (unsigned i = 0; i < SCALAR_COUNT; i++) {
+        printf("%-10s %lu\n", scalars[i].name, (unsigned long)*scalars[i].value);
+    }
+    if (active_sector >= 0) {
+        printf("store: sector %d seq %lu, %lu/%u bytes used, %lu staged\n",
+               active_sector, (unsigned long)active_seq,
+               (unsigned long)write_offset, FLASH_SECTOR_SIZE,
+               (unsigned long)stage_len);
+    } else {
+        printf("store: empty, %lu staged\n", (unsigned long)stage_len);
+    }
+}
+
+bool config_set_by_name(const char *name, uint32_t value) {
+    for (unsigned i = 0; i < SCALAR_COUNT; i++) {
+        if (strcmp(name, scalars[i].name) == 0) {
+            return config_set(scalars[i].key, value);
+        }
+    }
+    return false;
+}
@@ -0,0 +1,86 @@
+#ifndef _CONFIG_H_
+#define _CONFIG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "layouts.h"
+
+// ---------------------------------------------------------------------------
+// Persistent configuration
+//
+// Settings live in a small log-structured key/value store in the last flash
+// sectors. config_load() replays the log into RAM once at boot; after that
+// the firmware only reads the RAM copy. Writes update RAM immediately and
+// are staged, then flushed to flash from config_task() in the main loop.
+// ---------------------------------------------------------------------------
+
+// Defaults used when a setting has never been stored
+#define STROBE_DURATION_US   100     // ~100us to match original AY-5-3600
+#define RESET_DURATION_MS    250     // Power-on reset hold time
+#define LED_BLINK_MS         500     // LED blink half-period while searching
+#define PACE_US              25000   // Gap between generated keys (macros)
+#define SERIAL_BAUD          9600    // Serial ASCII output line rate
+
+// Output backends, combined in the outputs setting
+#define OUTPUT_BUS           0x01    // Parallel data + STROBE
+#define OUTPUT_SERIAL        0x02    // Serial ASCII on UART1
+#define OUTPUT_ALL           (OUTPUT_BUS | OUTPUT_SERIAL)
+
+// Keyboard layout used until one is selected (LAYOUT_US, LAYOUT_UK, ...)
+#ifndef LAYOUT_DEFAULT
+#define LAYOUT_DEFAULT       LAYOUT_US
+#endif
+
+// Record keys. Scalar settings are 32-bit values; ranges above
+// CONFIG_KEY_SCALAR_MAX are reserved for variable-length records owned by
+// other modules.
+#define CONFIG_KEY_STROBE_US      0x0001
+#define CONFIG_KEY_RESET_MS       0x0002
+#define CONFIG_KEY_LED_BLINK_MS   0x0003
+#define CONFIG_KEY_LAYOUT         0x0004
+#define CONFIG_KEY_PACE_US        0x0005
+#define CONFIG_KEY_MACRO_TIMED    0x0006
+#define CONFIG_KEY_ABBREV         0x0007
+#define CONFIG_KEY_OUTPUTS        0x0008
+#define CONFIG_KEY_SERIAL_BAUD    0x0009
+#define CONFIG_KEY_SCALAR_MAX     0x00FF
+#define CONFIG_KEY_REMAP_BASE     0x0100    // + source keycode (remap.c)
+#define CONFIG_KEY_MACRO_BASE     0x0200    // + slot (macro.c)
+#define CONFIG_KEY_CRASH          0x0300    // Last crash record (crashlog.c)
+#define CONFIG_KEY_PAD_KEYS       0x0301    // Gamepad button keys (gamepad.c)
+
+// Largest value a single record can hold
+#define CONFIG_VALUE_MAX          512
+
+typedef struct {
+    uint32_t strobe_us;
+    uint32_t reset_ms;
+    uint32_t led_blink_ms;
+    uint32_t layout;
+    uint32_t pace_us;
+    uint32_t macro_timed;
+    uint32_t abbrev;
+    uint32_t outputs;
+    uint32_t serial_baud;
+} config_t;
+
+extern config_t config;
+
+void config_load(void);
+void config_task(void);
+
+// Update a scalar setting in RAM and stage it for flash
+bool config_set(uint16_t key, uint32_t value);
+
+// Stage a variable-length record (len 0 deletes the key)
+bool config_write(uint16_t key, const void *data, uint16_t len);
+
+// Call fn for the latest copy of every stored record with key in [lo, hi]
+void config_for_each(uint16_t lo, uint16_t hi,
+                     void (*fn)(uint16_t key, const uint8_t *data, uint16_t len));
+
+void config_print(void);
+bool config_set_by_name(const char *name, uint32_t value);
+
+#endif
@@ -0,0 +1,400 @@
+/*
+ * UART command console
+ *
+ * Reads characters from the debug UART without blocking, collects them
+ * into a line and runs the matching command. Commands are looked up in a
+ * static table; each handler receives the whitespace-separated arguments.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "abbrev.h"
+#include "bench.h"
+#include "bus_trace.h"
+#include "compose.h"
+#include "config.h"
+#include "console.h"
+#include "crashlog.h"
+#include "devices.h"
+#include "fuzz.h"
+#include "gamepad.h"
+#include "paddle.h"
+#include "serial_out.h"
+#include "keyboard.h"
+#include "latch_model.h"
+#include "leds.h"
+#include "looptrace.h"
+#include "macro.h"
+#include "remap.h"
+#include "replay.h"
+#include "sched.h"
+#include "stackmon.h"
+#include "stats.h"
+#include "supervisor.h"
+
+#define CONSOLE_LINE_MAX   64
+#define CONSOLE_ARGS_MAX   8
+
+typedef struct {
+    const char *name;
+    const char *help;
+    void (*handler)(int argc, char **argv);
+} console_cmd_t;
+
+static void cmd_help(int argc, char **argv);
+
+static void cmd_stats(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    stats_print();
+}
+
+static void cmd_bus(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "clear") == 0) {
+        bus_trace_clear();
+        return;
+    }
+    bus_trace_print_timing();
+}
+
+static void cmd_vcd(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    bus_trace_dump_vcd();
+}
+
+static void cmd_config(int argc, char **argv) {
+    if (argc == 4 && strcmp(argv[1], "set") == 0) {
+        if (!config_set_by_name(argv[2], strtoul(argv[3], NULL, 0))) {
+            printf("Invalid setting or value\n");
+            return;
+        }
+    } else if (argc != 1) {
+        printf("Usage: config [set <name> <value>]\n");
+        return;
+    }
+    config_print();
+}
+
+static void cmd_remap(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "clear") == 0) {
+        remap_clear();
+    } else if (argc == 3) {
+        remap_set((uint8_t)strtoul(argv[1], NULL, 16),
+                  (uint8_t)strtoul(argv[2], NULL, 16));
+    } else if (argc != 1) {
+        printf("Usage: remap [<from> <to> | clear]  (hex keycodes)\n");
+        return;
+    }
+    remap_print();
+}
+
+static void cmd_macro(int argc, char **argv) {
+    int slot = argc > 2 ? atoi(argv[2]) - 1 : -1;
+    if (argc > 2 && strcmp(argv[1], "play") == 0) {
+        bool timed = argc > 3 && strcmp(argv[3], "timed") == 0;
+        if (!macro_play(slot, timed)) {
+            printf("Nothing to play\n");
+        }
+        return;
+    } else if (argc > 2 && strcmp(argv[1], "record") == 0) {
+        macro_record_toggle(slot);
+        return;
+    } else if (argc == 2 && strcmp(argv[1], "stop") == 0) {
+        macro_stop();
+    } else if (argc != 1) {
+        printf("Usage: macro [play <n> [timed] | record <n> | stop]\n");
+        return;
+    }
+    macro_print();
+}
+
+static void cmd_abbrev(int argc, char **argv) {
+    if (argc == 2 && (strcmp(argv[1], "on") == 0 || strcmp(argv[1], "off") == 0)) {
+        config_set(CONFIG_KEY_ABBREV, strcmp(argv[1], "on") == 0);
+    } else if (argc != 1) {
+        printf("Usage: abbrev [on|off]\n");
+        return;
+    }
+    abbrev_print();
+}
+
+static void cmd_compose(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    compose_print();
+}
+
+static void cmd_sched(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "clear") == 0) {
+        sched_clear();
+    } else if (argc != 1) {
+        printf("Usage: sched [clear]\n");
+        return;
+    }
+    sched_print();
+}
+
+static void cmd_loop(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "clear") == 0) {
+        looptrace_clear();
+    } else if (argc != 1) {
+        printf("Usage: loop [clear]\n");
+        return;
+    }
+    looptrace_print();
+}
+
+static void cmd_health(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    supervisor_print();
+}
+
+static void cmd_crash(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "clear") == 0) {
+        crashlog_clear();
+    } else if (argc == 2 && strcmp(argv[1], "fault") == 0) {
+        crashlog_test_fault();
+    } else if (argc == 2 && strcmp(argv[1], "panic") == 0) {
+        panic("console crash test");
+    } else if (argc != 1) {
+        printf("Usage: crash [clear|fault|panic]\n");
+    } else {
+        crashlog_print();
+    }
+}
+
+static void cmd_stack(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    stackmon_print();
+}
+
+static void cmd_game(int argc, char **argv) {
+    if (argc == 2 && (strcmp(argv[1], "on") == 0 || strcmp(argv[1], "off") == 0)) {
+        keyboard_set_profile(strcmp(argv[1], "on") == 0 ? PROFILE_GAME : PROFILE_NORMAL);
+    } else if (argc != 1) {
+        printf("Usage: game [on|off]\n");
+        return;
+    }
+    keyboard_print_latency();
+}
+
+static void cmd_pad(int argc, char **argv) {
+    if (argc == 4 && strcmp(argv[1], "key") == 0) {
+        if (!gamepad_set_key((uint8_t)strtoul(argv[2], NULL, 10),
+                             (uint8_t)strtoul(argv[3], NULL, 16))) {
+            printf("Button must be 1-%d\n", GAMEPAD_BUTTONS);
+            return;
+        }
+    } else if (argc != 1) {
+        printf("Usage: pad [key <button> <ascii hex, 0 = none>]\n");
+        return;
+    }
+    gamepad_print();
+}
+
+static void cmd_paddle(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "check") == 0) {
+        printf("%s\n", paddle_check() ? "Paddle timing OK" : "Paddle timing check FAILED");
+        return;
+    }
+    if (argc == 3) {
+        unsigned long n = strtoul(argv[1], NULL, 10);
+        unsigned long v = strtoul(argv[2], NULL, 10);
+        if (n >= PADDLE_COUNT || v > 255) {
+            printf("Paddle must be 0-%d, value 0-255\n", PADDLE_COUNT - 1);
+            return;
+        }
+        paddle_set((uint8_t)n, (uint8_t)v);
+    } else if (argc != 1) {
+        printf("Usage: paddle [check|<n> <value>]\n");
+        return;
+    }
+    paddle_print();
+}
+
+static void cmd_serial(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    serial_out_print();
+}
+
+static void cmd_usb(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    kbd_device_print();
+}
+
+static void cmd_leds(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    leds_print();
+}
+
+static void cmd_layout(int argc, char **argv) {
+    if (argc > 1) {
+        if (strcmp(argv[1], "verify") == 0) {
+            printf("%s\n", layout_verify() ? "Layouts OK" : "Layout check FAILED");
+            return;
+        }
+        layout_id_t id = layout_find(argv[1]);
+        if (id == LAYOUT_COUNT) {
+            printf("Unknown layout '%s'\n", argv[1]);
+            return;
+        }
+        keyboard_set_layout(id);
+        config_set(CONFIG_KEY_LAYOUT, id);
+    }
+    for (int i = 0; i < LAYOUT_COUNT; i++) {
+        printf("%c %s\n", i == (int)keyboard_get_layout() ? '*' : ' ',
+               layouts[i].name);
+    }
+}
+
+static void cmd_latch(int argc, char **argv) {
+    if (argc > 1 && !latch_model_select(argv[1])) {
+        printf("Unknown pattern '%s' (getln, basic, game)\n", argv[1]);
+        return;
+    }
+    latch_model_print();
+}
+
+static bool parse_hex_bytes(const char *hex, uint8_t *out, size_t len) {
+    if (strlen(hex) != len * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        char byte[3] = { hex[2 * i], hex[2 * i + 1], '\0' };
+        char *end;
+        out[i] = (uint8_t)strtoul(byte, &end, 16);
+        if (*end != '\0') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// r <delta_us> <16 hex digits>: append one report to the replay buffer
+static void cmd_replay_add(int argc, char **argv) {
+    hid_keyboard_report_t report;
+    if (argc != 3 || !parse_hex_bytes(argv[2], (uint8_t *)&report, sizeof(report))) {
+        printf("Usage: r <delta_us> <16 hex digits>\n");
+        return;
+    }
+    if (!replay_add(strtoul(argv[1], NULL, 10), &report)) {
+        printf("Replay buffer full or busy\n");
+    }
+}
+
+static void cmd_replay(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "clear") == 0) {
+        replay_clear();
+    } else if (argc > 1 && strcmp(argv[1], "run") == 0) {
+        uint32_t speed = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+        bool mute = argc > 3 && strcmp(argv[3], "mute") == 0;
+        replay_start(speed, mute);
+    } else if (argc > 1 && strcmp(argv[1], "stop") == 0) {
+        replay_stop();
+    } else {
+        printf("Usage: replay clear | run [speed] [mute] | stop\n");
+    }
+}
+
+static void cmd_bench(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    bench_run();
+}
+
+static void cmd_fuzz(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "desc") == 0) {
+        uint32_t count = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000;
+        uint32_t seed  = argc > 3 ? strtoul(argv[3], NULL, 10) : time_us_32();
+        fuzz_descriptors(count, seed);
+        return;
+    }
+    uint32_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+    uint32_t seed  = argc > 2 ? strtoul(argv[2], NULL, 10) : time_us_32();
+    fuzz_start(count, seed);
+}
+
+static const console_cmd_t commands[] = {
+    { "help",  "list commands",               cmd_help  },
+    { "stats", "event counters and rates",    cmd_stats },
+    { "sched", "task CPU time and overruns [clear]", cmd_sched },
+    { "loop",  "main loop / USB service latency [clear]", cmd_loop },
+    { "stack", "stack high-water marks",      cmd_stack },
+    { "config", "show/set persistent settings", cmd_config },
+    { "layout", "list/select layout [name|verify]", cmd_layout },
+    { "remap", "list/set key remaps",         cmd_remap },
+    { "macro", "list/play/record macros",     cmd_macro },
+    { "abbrev", "list abbreviations [on|off]", cmd_abbrev },
+    { "compose", "list compose sequences",    cmd_compose },
+    { "game",  "game mode profile, key latency [on|off]", cmd_game },
+    { "usb",   "keyboards, protocol, poll timing", cmd_usb },
+    { "pad",   "gamepads, button keys [key <b> <hex>]", cmd_pad },
+    { "paddle", "paddle outputs [check|<n> <value>]", cmd_paddle },
+    { "serial", "serial ASCII output counters", cmd_serial },
+    { "health", "watchdog and USB stall recovery", cmd_health },
+    { "crash", "last crash record [clear|fault|panic]", cmd_crash },
+    { "leds",  "keyboard LED report counters", cmd_leds },
+    { "bus",   "bus timing checks [clear]",   cmd_bus   },
+    { "vcd",   "dump bus trace as VCD",       cmd_vcd   },
+    { "latch", "Apple II latch model [pattern]", cmd_latch },
+    { "r",     "queue a report for replay",   cmd_replay_add },
+    { "replay", "replay queued reports",      cmd_replay },
+    { "fuzz",  "fuzz report path [desc] [n] [seed]", cmd_fuzz },
+    { "bench", "hot path cycle benchmarks",   cmd_bench },
+};
+
+#define COMMAND_COUNT (sizeof(commands) / sizeof(commands[0]))
+
+static void cmd_help(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    for (unsigned i = 0; i < COMMAND_COUNT; i++) {
+        printf("  %-8s %s\n", commands[i].name, commands[i].help);
+    }
+}
+
+static void dispatch(char *line) {
+    char *argv[CONSOLE_ARGS_MAX];
+    int argc = 0;
+
+    for (char *tok = strtok(line, " \t"); tok && argc < CONSOLE_ARGS_MAX;
+         tok = strtok(NULL, " \t")) {
+        argv[argc++] = tok;
+    }
+    if (argc == 0) {
+        return;
+    }
+
+    for (unsigned i = 0; i < COMMAND_COUNT; i++) {
+        if (strcmp(argv[0], commands[i].name) == 0) {
+            commands[i].handler(argc, argv);
+            return;
+        }
+    }
+    printf("Unknown command '%s' (try 'help')\n", argv[0]);
+}
+
+void console_task(void) {
+    static char line[CONSOLE_LINE_MAX];
+    static int len = 0;
+
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if (c == '\r' || c == '\n') {
+            line[len] = '\0';
+            dispatch(line);
+            len = 0;
+        } else if (len < CONSOLE_LINE_MAX - 1) {
+            line[len++] = (char)c;
+        }
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef _CONSOLE_H_
+#define _CONSOLE_H_
+
+// ---------------------------------------------------------------------------
+// UART command console
+//
+// Polls stdio without blocking and dispatches one command per line. Called
+// from the main loop, never from USB callbacks.
+// ---------------------------------------------------------------------------
+void console_task(void);
+
+#endif
@@ -0,0 +1,302 @@
+/*
+ * Crash capture
+ *
+ * The HardFault entry is a short assembly stub: it picks the stack the
+ * exception frame was pushed to (bit 2 of EXC_RETURN), moves onto a
+ * reserved fault stack, saves r4-r11, which the exception entry does not
+ * stack, and calls crash_hardfault(). Nothing is pushed to the faulting
+ * stack, so an overflow that left SP at the edge of RAM is still captured
+ * (a fault while the core stacks the exception frame itself is a lockup
+ * and cannot be). Every pointer read while capturing is range-checked
+ * first, since a fault is often caused by a corrupt stack pointer.
+ *
+ * panic() in the SDK pushes lr and calls PICO_PANIC_FUNCTION, so
+ * crash_panic() is also a stub: the word at its entry SP is the return
+ * address into panic()'s caller.
+ *
+ * The RAM record is recognised on the next boot by its magic and a word
+ * checksum; a reset that interrupted the capture leaves a bad checksum
+ * and is ignored.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "bus_trace.h"
+#include "config.h"
+#include "crashlog.h"
+#include "looptrace.h"
+#include "supervisor.h"
+
+#define CRASH_MAGIC         0x48535243      // "CRSH"
+#define CRASH_STACK_WORDS   32
+#define CRASH_BUS_SAMPLES   16
+#define CRASH_TEXT_MAX      40
+
+#define CRASH_HARDFAULT     1
+#define CRASH_PANIC         2
+
+#define RAM_START           0x20000000u
+#define RAM_END             0x20042000u
+#define FLASH_START         0x10000000u
+#define FLASH_END           0x11000000u
+
+#define FAULT_STACK_BYTES   1024
+#define STR_(x)             #x
+#define STR(x)              STR_(x)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t kind;
+    uint32_t uptime_ms;
+    uint32_t frame[8];          // r0 r1 r2 r3 r12 lr pc xpsr
+    uint32_t r4_r11[8];
+    uint32_t sp;
+    uint32_t exc_return;
+    char message[CRASH_TEXT_MAX];
+    char site[CRASH_TEXT_MAX];
+    uint32_t stack_words;
+    uint32_t stack[CRASH_STACK_WORDS];
+    uint32_t report_count;
+    uint8_t reports[CRASH_REPORTS][8];      // Oldest first
+    uint32_t bus_count;
+    bus_trace_entry_t bus[CRASH_BUS_SAMPLES];
+    uint32_t check;
+} crash_record_t;
+
+_Static_assert(sizeof(crash_record_t) <= CONFIG_VALUE_MAX, "crash record too large");
+
+// Survives the reboot that follows a crash
+crash_record_t __uninitialized_ram(crash_record);
+
+// Used by isr_hardfault in place of the stack that faulted
+uint8_t __attribute__((aligned(8))) fault_stack[FAULT_STACK_BYTES];
+
+uint8_t crash_reports[CRASH_REPORTS][8];
+uint32_t crash_report_head = 0;
+
+// ---------------------------------------------------------------------------
+// Capture
+// ---------------------------------------------------------------------------
+
+static bool in_ram(uint32_t addr, uint32_t len) {
+    return addr >= RAM_START && addr <= RAM_END - len && (addr & 3) == 0;
+}
+
+static bool readable(const void *p) {
+    uint32_t addr = (uint32_t)(uintptr_t)p;
+    return (addr >= FLASH_START && addr < FLASH_END) || (addr >= RAM_START && addr < RAM_END);
+}
+
+static void copy_text(char *dst, const char *src) {
+    uint32_t i = 0;
+    if (src && readable(src)) {
+        for (; i < CRASH_TEXT_MAX - 1 && src[i]; i++) {
+            dst[i] = src[i];
+        }
+    }
+    dst[i] = '\0';
+}
+
+static uint32_t checksum(const crash_record_t *r) {
+    const uint32_t *w = (const uint32_t *)r;
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < offsetof(crash_record_t, check) / 4; i++) {
+        sum = (sum << 1 | sum >> 31) ^ w[i];
+    }
+    return ~sum;
+}
+
+static void __attribute__((noreturn))
+capture(uint32_t kind, uint32_t sp, const char *message) {
+    crash_record_t *r = &crash_record;
+
+    r->magic = CRASH_MAGIC;
+    r->kind = kind;
+    r->uptime_ms = to_ms_since_boot(get_absolute_time());
+    r->sp = sp;
+    copy_text(r->message, message);
+    copy_text(r->site, looptrace_current_site());
+
+    r->stack_words = 0;
+    while (r->stack_words < CRASH_STACK_WORDS &&
+           in_ram(sp + r->stack_words * 4, 4)) {
+        r->stack[r->stack_words] = ((const uint32_t *)(uintptr_t)sp)[r->stack_words];
+        r->stack_words++;
+    }
+
+    r->report_count = crash_report_head < CRASH_REPORTS ? crash_report_head : CRASH_REPORTS;
+    for (uint32_t i = 0; i < r->report_count; i++) {
+        memcpy(r->reports[i],
+               crash_reports[(crash_report_head - r->report_count + i) & (CRASH_REPORTS - 1)], 8);
+    }
+
+    r->bus_count = bus_trace_latest(r->bus, CRASH_BUS_SAMPLES);
+    r->check = checksum(r);
+
+    supervisor_reboot(SUPERVISOR_REASON_CRASH);
+}
+
+// Called from isr_hardfault with the exception frame, EXC_RETURN and the
+// saved r8-r11, r4-r7
+void __attribute__((used, noreturn))
+crash_hardfault(uint32_t *frame, uint32_t exc_return, uint32_t *saved) {
+    crash_record_t *r = &crash_record;
+    uint32_t sp = (uint32_t)(uintptr_t)frame;
+
+    memset(r->frame, 0, sizeof(r->frame));
+    if (in_ram(sp, sizeof(r->frame))) {
+        memcpy(r->frame, frame, sizeof(r->frame));
+    }
+    for (int i = 0; i < 4; i++) {
+        r->r4_r11[i] = saved[4 + i];
+        r->r4_r11[4 + i] = saved[i];
+    }
+    r->exc_return = exc_return;
+
+    // The stack as it was before the exception frame was pushed
+    capture(CRASH_HARDFAULT, sp + sizeof(r->frame), "HardFault");
+}
+
+void __attribute__((naked)) isr_hardfault(void) {
+    __asm volatile (
+        "movs r0, #4\n"
+        "mov  r1, lr\n"
+        "tst  r0, r1\n"
+        "beq  1f\n"
+        "mrs  r0, psp\n"
+        "b    2f\n"
+        "1:\n"
+        "mrs  r0, msp\n"
+        "2:\n"
+        "ldr  r2, 3f\n"
+        "mov  sp, r2\n"
+        "push {r4-r7}\n"
+        "mov  r4, r8\n"
+        "mov  r5, r9\n"
+        "mov  r6, r10\n"
+        "mov  r7, r11\n"
+        "push {r4-r7}\n"
+        "mov  r2, sp\n"
+        "bl   crash_hardfault\n"
+        ".align 2\n"
+        "3: .word fault_stack + " STR(FAULT_STACK_BYTES) "\n"
+    );
+}
+
+// Called from crash_panic with the return address into panic()'s caller
+// and the caller's stack pointer
+void __attribute__((used, noreturn))
+crash_panic_capture(const char *fmt, uint32_t caller, uint32_t sp) {
+    crash_record_t *r = &crash_record;
+
+    memset(r->frame, 0, sizeof(r->frame));
+    memset(r->r4_r11, 0, sizeof(r->r4_r11));
+    r->frame[5] = caller;
+    r->exc_return = 0;
+
+    // The format string is kept unformatted: formatting could allocate
+    capture(CRASH_PANIC, sp, fmt);
+}
+
+void __attribute__((naked)) crash_panic(const char *fmt, ...) {
+    __asm volatile (
+        "ldr  r1, [sp]\n"          // lr pushed by panic()
+        "mov  r2, sp\n"
+        "adds r2, #4\n"
+        "bl   crash_panic_capture\n"
+    );
+}
+
+void crashlog_test_fault(void) {
+    // Reading unmapped address space raises a bus fault, which the M0+
+    // escalates to HardFault
+    volatile uint32_t *bad = (volatile uint32_t *)(uintptr_t)0xF0000000u;
+    (void)*bad;
+}
+
+// ---------------------------------------------------------------------------
+// Storage and dump
+// ---------------------------------------------------------------------------
+
+void crashlog_init(void) {
+    crash_record_t *r = &crash_record;
+    if (r->magic != CRASH_MAGIC || r->check != checksum(r)) {
+        return;
+    }
+    r->magic = 0;
+
+    printf("Crash record from previous run: %s in %s, pc %08lX\n",
+           r->message, r->site, (unsigned long)r->frame[6]);
+    if (!config_write(CONFIG_KEY_CRASH, r, sizeof(*r))) {
+        printf("Warning: crash record not saved\n");
+    }
+}
+
+static void print_record(uint16_t key, const uint8_t *data, uint16_t len) {
+    static const char *const regs[] = { "r0", "r1", "r2", "r3", "r12", "lr", "pc", "xpsr" };
+    crash_record_t r;
+
+    (void)key;
+    if (len != sizeof(r)) {
+        printf("crash record has unexpected size %d\n", len);
+        return;
+    }
+    memcpy(&r, data, sizeof(r));
+
+    printf("%s after %lu ms: %s\n", r.kind == CRASH_PANIC ? "panic" : "HardFault",
+           (unsigned long)r.uptime_ms, r.message);
+    printf("site  %s\n", r.site);
+    for (int i = 0; i < 8; i++) {
+        printf("%-4s  %08lX%s", regs[i], (unsigned long)r.frame[i], i % 4 == 3 ? "\n" : "  ");
+    }
+    for (int i = 0; i < 8; i++) {
+        printf("r%-3d  %08lX%s", 4 + i, (unsigned long)r.r4_r11[i], i % 4 == 3 ? "\n" : "  ");
+    }
+    printf("sp    %08lX  exc_return %08lX\n", (unsigned long)r.sp,
+           (unsigned long)r.exc_return);
+
+    printf("stack:\n");
+    for (uint32_t i = 0; i < r.stack_words && i < CRASH_STACK_WORDS; i++) {
+        printf("%s%08lX", i % 8 == 0 ? "  " : " ", (unsigned long)r.stack[i]);
+        if (i % 8 == 7 || i + 1 == r.stack_words) {
+            printf("\n");
+        }
+    }
+
+    printf("reports (oldest first):\n");
+    for (uint32_t i = 0; i < r.report_count && i < CRASH_REPORTS; i++) {
+        printf(" ");
+        for (int b = 0; b < 8; b++) {
+            printf(" %02X", r.reports[i][b]);
+        }
+        printf("\n");
+    }
+
+    printf("bus (time_us sample):\n");
+    for (uint32_t i = 0; i < r.bus_count && i < CRASH_BUS_SAMPLES; i++) {
+        printf("  %10lu %03X\n", (unsigned long)r.bus[i].time_us, r.bus[i].sample);
+    }
+}
+
+static bool found;
+
+static void print_found(uint16_t key, const uint8_t *data, uint16_t len) {
+    found = true;
+    print_record(key, data, len);
+}
+
+void crashlog_print(void) {
+    found = false;
+    config_for_each(CONFIG_KEY_CRASH, CONFIG_KEY_CRASH, print_found);
+    if (!found) {
+        printf("no crash recorded\n");
+    }
+}
+
+void crashlog_clear(void) {
+    config_write(CONFIG_KEY_CRASH, NULL, 0);
+}
@@ -0,0 +1,40 @@
+#ifndef _CRASHLOG_H_
+#define _CRASHLOG_H_
+
+#include <stdint.h>
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+// Crash capture
+//
+// A HardFault or panic() snapshots registers, the top of the stack, the
+// running main-loop site, the last keyboard reports and the last bus
+// transitions into a record in RAM that the C runtime does not clear, then
+// reboots. On the next boot crashlog_init() moves a valid record into the
+// config store, where it stays until cleared from the console.
+//
+// The capture path uses no heap, no stdio and fixed-size copies only.
+// ---------------------------------------------------------------------------
+#define CRASH_REPORTS   8       // Power of two
+
+extern uint8_t crash_reports[CRASH_REPORTS][8];
+extern uint32_t crash_report_head;
+
+// Remember a raw keyboard report (called for every report received)
+static inline void crashlog_report(const void *report) {
+    memcpy(crash_reports[crash_report_head++ & (CRASH_REPORTS - 1)], report, 8);
+}
+
+// Call after config_load()
+void crashlog_init(void);
+
+void crashlog_print(void);
+void crashlog_clear(void);
+
+// Deliberately crash, to check the capture path
+void crashlog_test_fault(void);
+
+// panic() lands here (PICO_PANIC_FUNCTION)
+void crash_panic(const char *fmt, ...) __attribute__((noreturn));
+
+#endif
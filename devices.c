@@ -0,0 +1,307 @@
+/*
+ * Mounted keyboards
+ *
+ * Poll timing: a keyboard only answers an interrupt IN poll when its
+ * report changed, so report-to-report gaps while typing are multiples of
+ * the polling interval the host actually achieves. The shortest gap seen
+ * approximates that interval, and the distance of each gap from the
+ * nearest multiple of bInterval measures jitter. Gaps longer than
+ * TIMING_GAP_MAX_US are idle time and ignored.
+ *
+ * bInterval is not exposed by the HID host driver, so it is read from the
+ * configuration descriptor after mount, one device at a time through a
+ * shared buffer.
+ *
+ * Hot-plug cache: a keyboard coming back through a KVM switch presents
+ * the same descriptors, so what was learnt from them is kept in a small
+ * RAM table keyed by VID/PID and interface instance. For keyboards that
+ * is the polling interval: a cache hit skips the extra configuration
+ * descriptor read this module makes, leaving the control pipe free for
+ * the boot protocol and LED requests (gamepad plans are cached in
+ * gamepad.c). Enumeration itself is
+ * TinyUSB's and still runs in full; the serial string is not used as a
+ * key because reading it would cost another control transfer.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "devices.h"
+
+#define TIMING_GAP_MAX_US   250000
+#define CONFIG_DESC_BUFSIZE 256
+
+#define KBD_CACHE_MAX       8
+
+typedef struct {
+    uint16_t vid;
+    uint16_t pid;
+    uint8_t instance;
+    uint8_t interval_ms;        // 0 marks an unused entry
+    uint32_t mounts;
+    uint32_t first_report_us;   // Last mount-to-first-report time
+    uint32_t used;              // LRU stamp
+} kbd_cache_t;
+
+static uint8_t desc_buf[CONFIG_DESC_BUFSIZE];
+static bool desc_busy = false;
+
+static kbd_cache_t cache[KBD_CACHE_MAX];
+static uint32_t cache_clock = 0;
+static uint32_t cache_hits = 0;
+static uint32_t cache_misses = 0;
+
+kbd_device_t kbd_devices[KBD_DEVICE_MAX];
+
+// ---------------------------------------------------------------------------
+// Descriptor cache
+// ---------------------------------------------------------------------------
+
+static kbd_cache_t *cache_find(const kbd_device_t *d) {
+    for (int i = 0; i < KBD_CACHE_MAX; i++) {
+        kbd_cache_t *c = &cache[i];
+        if (c->interval_ms && c->vid == d->vid && c->pid == d->pid &&
+            c->instance == d->instance) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+// Record a device, evicting the least recently used entry when full
+static void cache_store(const kbd_device_t *d) {
+    kbd_cache_t *c = cache_find(d);
+    for (int i = 0; !c && i < KBD_CACHE_MAX; i++) {
+        if (!cache[i].interval_ms) {
+            c = &cache[i];
+        }
+    }
+    if (!c) {
+        c = &cache[0];
+        for (int i = 1; i < KBD_CACHE_MAX; i++) {
+            if (cache[i].used < c->used) {
+                c = &cache[i];
+            }
+        }
+    }
+    if (c->vid != d->vid || c->pid != d->pid || c->instance != d->instance) {
+        memset(c, 0, sizeof(*c));
+        c->vid = d->vid;
+        c->pid = d->pid;
+        c->instance = d->instance;
+        c->mounts = 1;
+    }
+    c->interval_ms = d->interval_ms;
+    c->used = ++cache_clock;
+}
+
+// ---------------------------------------------------------------------------
+// Devices
+// ---------------------------------------------------------------------------
+
+kbd_device_t *kbd_device_find(uint8_t dev_addr, uint8_t instance) {
+    for (int i = 0; i < KBD_DEVICE_MAX; i++) {
+        kbd_device_t *d = &kbd_devices[i];
+        if (d->mounted && d->dev_addr == dev_addr && d->instance == instance) {
+            return d;
+        }
+    }
+    return NULL;
+}
+
+kbd_device_t *kbd_device_add(uint8_t dev_addr, uint8_t instance) {
+    kbd_device_t *d = kbd_device_find(dev_addr, instance);
+    for (int i = 0; !d && i < KBD_DEVICE_MAX; i++) {
+        if (!kbd_devices[i].mounted) {
+            d = &kbd_devices[i];
+        }
+    }
+    if (d) {
+        memset(d, 0, sizeof(*d));
+        d->mounted = true;
+        d->dev_addr = dev_addr;
+        d->instance = instance;
+        d->led_sent = 0xFF;
+        d->gap_min_us = UINT32_MAX;
+        d->mount_us = time_us_64();
+        tuh_vid_pid_get(dev_addr, &d->vid, &d->pid);
+
+        kbd_cache_t *c = cache_find(d);
+        if (c) {
+            d->interval_ms = c->interval_ms;
+            d->cached = true;
+            c->mounts++;
+            c->used = ++cache_clock;
+            cache_hits++;
+        } else {
+            cache_misses++;
+        }
+    }
+    return d;
+}
+
+void kbd_device_remove(uint8_t dev_addr, uint8_t instance) {
+    kbd_device_t *d = kbd_device_find(dev_addr, instance);
+    if (d) {
+        d->mounted = false;
+    }
+}
+
+void kbd_device_remove_all(void) {
+    for (int i = 0; i < KBD_DEVICE_MAX; i++) {
+        kbd_devices[i].mounted = false;
+    }
+    // A descriptor read in flight died with the host stack
+    desc_busy = false;
+}
+
+bool kbd_device_any_mounted(void) {
+    for (int i = 0; i < KBD_DEVICE_MAX; i++) {
+        if (kbd_devices[i].mounted) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Find bInterval of the interrupt IN endpoint of interface 'itf_num'
+static uint8_t parse_interval(const uint8_t *desc, uint16_t len, uint8_t itf_num) {
+    bool in_itf = false;
+    for (uint16_t off = 0; off + 2 <= len && desc[off] >= 2; off += desc[off]) {
+        uint8_t type = desc[off + 1];
+        if (type == TUSB_DESC_INTERFACE && off + sizeof(tusb_desc_interface_t) <= len) {
+            const tusb_desc_interface_t *itf = (const tusb_desc_interface_t *)&desc[off];
+            in_itf = itf->bInterfaceNumber == itf_num;
+        } else if (type == TUSB_DESC_ENDPOINT && in_itf &&
+                   off + sizeof(tusb_desc_endpoint_t) <= len) {
+            const tusb_desc_endpoint_t *ep = (const tusb_desc_endpoint_t *)&desc[off];
+            if ((ep->bEndpointAddress & TUSB_DIR_IN_MASK) &&
+                (ep->bmAttributes & 0x03) == TUSB_XFER_INTERRUPT) {
+                return ep->bInterval;
+            }
+        }
+    }
+    return 0;
+}
+
+static void config_desc_complete(tuh_xfer_t *xfer) {
+    desc_busy = false;
+
+    // The slot may have been reused by another device since the request
+    kbd_device_t *d = &kbd_devices[xfer->user_data];
+    bool same = d->mounted && d->dev_addr == xfer->daddr;
+    tuh_itf_info_t info;
+    if (xfer->result == XFER_RESULT_SUCCESS && same &&
+        tuh_hid_itf_get_info(d->dev_addr, d->instance, &info)) {
+        d->interval_ms = parse_interval(desc_buf, (uint16_t)xfer->actual_len,
+                                        info.desc.bInterfaceNumber);
+        if (d->interval_ms) {
+            cache_store(d);
+        }
+        printf("Keyboard dev=%d: %s protocol, polled every %d ms\n", d->dev_addr,
+               d->protocol == HID_PROTOCOL_BOOT ? "boot" : "report", d->interval_ms);
+    }
+
+    // Another keyboard may have been waiting for the buffer, whether or
+    // not this read succeeded. A keyboard whose read failed is not asked
+    // again until it remounts.
+    for (int i = 0; i < KBD_DEVICE_MAX; i++) {
+        if (kbd_devices[i].mounted && kbd_devices[i].interval_ms == 0 &&
+            !(same && &kbd_devices[i] == d)) {
+            kbd_device_query_interval(&kbd_devices[i]);
+            break;
+        }
+    }
+}
+
+void kbd_device_query_interval(kbd_device_t *d) {
+    if (d->interval_ms) {
+        printf("Keyboard dev=%d: cached, polled every %d ms\n", d->dev_addr,
+               d->interval_ms);
+        return;
+    }
+    if (desc_busy) {
+        return;
+    }
+    desc_busy = tuh_descriptor_get_configuration(d->dev_addr, 0, desc_buf,
+                                                 sizeof(desc_buf),
+                                                 config_desc_complete,
+                                                 (uintptr_t)(d - kbd_devices));
+}
+
+void kbd_device_report_timing(kbd_device_t *d) {
+    uint64_t now = time_us_64();
+    uint64_t last = d->last_report_us;
+    d->last_report_us = now;
+    if (d->reports++ == 0) {
+        d->first_report_us = (uint32_t)(now - d->mount_us);
+        kbd_cache_t *c = cache_find(d);
+        if (c) {
+            c->first_report_us = d->first_report_us;
+        }
+    }
+
+    if (last == 0 || now - last > TIMING_GAP_MAX_US) {
+        return;
+    }
+
+    uint32_t gap = (uint32_t)(now - last);
+    if (gap < d->gap_min_us) {
+        d->gap_min_us = gap;
+    }
+
+    if (d->interval_ms) {
+        uint32_t period = d->interval_ms * 1000u;
+        uint32_t off = gap % period;
+        uint32_t jitter = off < period - off ? off : period - off;
+        if (jitter > d->jitter_max_us) {
+            d->jitter_max_us = jitter;
+        }
+        d->jitter_sum_us += jitter;
+        d->gap_samples++;
+    }
+}
+
+void kbd_device_print(void) {
+    bool any = false;
+    for (int i = 0; i < KBD_DEVICE_MAX; i++) {
+        const kbd_device_t *d = &kbd_devices[i];
+        if (!d->mounted) {
+            continue;
+        }
+        any = true;
+        printf("dev %d.%d %04X:%04X %s protocol, bInterval %d ms, %lu reports\n",
+               d->dev_addr, d->instance, d->vid, d->pid,
+               d->protocol == HID_PROTOCOL_BOOT ? "boot" : "report",
+               d->interval_ms, (unsigned long)d->reports);
+        if (d->gap_min_us != UINT32_MAX) {
+            printf("  fastest gap %lu us (%lu Hz)", (unsigned long)d->gap_min_us,
+                   (unsigned long)(1000000u / d->gap_min_us));
+            if (d->gap_samples) {
+                printf(", jitter avg %lu us max %lu us",
+                       (unsigned long)(d->jitter_sum_us / d->gap_samples),
+                       (unsigned long)d->jitter_max_us);
+            }
+            printf("\n");
+        }
+        if (d->first_report_us) {
+            printf("  first report %lu us after mount%s\n",
+                   (unsigned long)d->first_report_us, d->cached ? " (cached)" : "");
+        }
+    }
+    if (!any) {
+        printf("no keyboards\n");
+    }
+
+    printf("cache: %lu hits, %lu misses\n", (unsigned long)cache_hits,
+           (unsigned long)cache_misses);
+    for (int i = 0; i < KBD_CACHE_MAX; i++) {
+        const kbd_cache_t *c = &cache[i];
+        if (c->interval_ms) {
+            printf("  %04X:%04X.%d bInterval %d ms, %lu mounts, last first report %lu us\n",
+                   c->vid, c->pid, c->instance, c->interval_ms,
+                   (unsigned long)c->mounts, (unsigned long)c->first_report_us);
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef _DEVICES_H_
+#define _DEVICES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tusb.h"
+
+// ---------------------------------------------------------------------------
+// Mounted keyboards
+//
+// One entry per HID keyboard interface, filled in by tuh_hid_mount_cb()
+// and cleared by tuh_hid_umount_cb(). Modules that need per-keyboard state
+// (LED output reports, ...) keep it here.
+// ---------------------------------------------------------------------------
+#define KBD_DEVICE_MAX   CFG_TUH_HID
+
+typedef struct {
+    bool mounted;
+    uint8_t dev_addr;
+    uint8_t instance;
+
+    // Keyboard LED output report (leds.c)
+    uint8_t led_report;         // Buffer owned by the in-flight transfer
+    uint8_t led_sent;           // Last value sent, 0xFF if none yet
+    bool led_busy;              // SET_REPORT in flight
+    uint32_t led_sent_ms;       // When the in-flight SET_REPORT started
+    uint32_t led_changes_seen;  // leds_changes value covered by led_sent
+
+    // Protocol and polling
+    uint8_t protocol;           // HID_PROTOCOL_BOOT / HID_PROTOCOL_REPORT
+    uint8_t interval_ms;        // Interrupt IN bInterval, 0 until known
+    uint16_t vid;
+    uint16_t pid;
+    uint64_t last_report_us;
+    uint32_t reports;
+    uint32_t gap_min_us;        // Shortest report-to-report gap seen
+    uint32_t gap_samples;       // Gaps used for jitter (key activity only)
+    uint32_t jitter_max_us;     // Worst distance from a poll boundary
+    uint64_t jitter_sum_us;
+
+    // Hot-plug
+    bool cached;                // Interval taken from the hot-plug cache
+    uint64_t mount_us;
+    uint32_t first_report_us;   // Mount to first report, 0 until seen
+} kbd_device_t;
+
+extern kbd_device_t kbd_devices[KBD_DEVICE_MAX];
+
+kbd_device_t *kbd_device_add(uint8_t dev_addr, uint8_t instance);
+kbd_device_t *kbd_device_find(uint8_t dev_addr, uint8_t instance);
+void kbd_device_remove(uint8_t dev_addr, uint8_t instance);
+void kbd_device_remove_all(void);
+bool kbd_device_any_mounted(void);
+
+// Start reading the keyboard's endpoint interval (asynchronous). Does
+// nothing when the interval is already known from the hot-plug cache.
+void kbd_device_query_interval(kbd_device_t *d);
+
+// Update poll timing from a report arriving now
+void kbd_device_report_timing(kbd_device_t *d);
+
+void kbd_device_print(void);
+
+#endif
@@ -0,0 +1,302 @@
+/*
+ * Report fuzzer
+ *
+ * Keys queued by each report are drained immediately, so the per-report
+ * checks see exactly the keys that report produced.
+ *
+ * Each run replays the same pseudo-random report sequence twice from a
+ * clean keyboard state and compares a hash of the emitted keys, so any
+ * dependence on uninitialised or out-of-bounds data shows up as a
+ * mismatch. Per report it checks:
+ *
+ *   - at most one key per keycode slot is emitted
+ *   - every emitted key is a non-zero 7-bit code (or KEY_CODE_NUL)
+ *   - processing time stays under FUZZ_MAX_REPORT_US
+ *
+ * Abbreviation expansion is switched off for the run (in RAM only): a
+ * completed trigger legitimately queues a whole expansion from one report.
+ *
+ * Generated reports mix fully random bytes with realistic ones (held keys,
+ * rollover, modifier-only changes, repeats) so both the table bounds and
+ * the report differ get exercised.
+ *
+ * fuzz_descriptors() mutates a valid gamepad report descriptor (random
+ * byte flips, truncation, and runs of random items) and checks that every
+ * plan hid_parse_plan() returns stays inside its limits and decodes a
+ * random report without reading past its end.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "compose.h"
+#include "fuzz.h"
+#include "abbrev.h"
+#include "config.h"
+#include "hid_parse.h"
+#include "keyboard.h"
+#include "keyq.h"
+#include "macro.h"
+#include "stats.h"
+
+#define FUZZ_SLICE           256     // Reports per main loop pass
+#define FUZZ_MAX_REPORT_US   500     // Muted path must never take longer
+#define FUZZ_MAX_DESC_US     2000    // Descriptor parse at mount
+#define FUZZ_DESC_MAX        128
+
+typedef struct {
+    uint32_t reports;
+    uint32_t keys;
+    uint32_t hash;
+    uint32_t max_events;
+    uint32_t max_us;
+    uint32_t bad_events;
+    uint32_t bad_codes;
+    uint32_t slow;
+} fuzz_result_t;
+
+static bool running = false;
+static int pass = 0;
+static uint32_t iterations = 0;
+static uint32_t seed = 0;
+static uint32_t rng = 0;
+static uint32_t done = 0;
+static hid_keyboard_report_t last;
+static fuzz_result_t results[2];
+static fuzz_result_t *cur = &results[0];
+static uint32_t report_keys = 0;
+static layout_id_t saved_layout;
+static keyboard_profile_t saved_profile;
+static uint32_t saved_abbrev;
+
+static uint32_t xorshift32(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void tap(uint8_t ascii) {
+    cur->keys++;
+    report_keys++;
+    cur->hash = (cur->hash ^ ascii) * 16777619u;   // FNV-1a
+    if (ascii == 0 || (ascii >= 0x80 && ascii != KEY_CODE_NUL)) {
+        cur->bad_codes++;
+    }
+}
+
+static void next_report(hid_keyboard_report_t *r) {
+    uint32_t kind = xorshift32() % 8;
+
+    if (kind == 0) {
+        // Garbage: every byte random, including reserved and keycodes > 0xA4
+        uint8_t *bytes = (uint8_t *)r;
+        for (size_t i = 0; i < sizeof(*r); i++) {
+            bytes[i] = (uint8_t)xorshift32();
+        }
+    } else if (kind == 1) {
+        // Exact repeat
+        *r = last;
+    } else if (kind == 2) {
+        // Modifier-only change
+        *r = last;
+        r->modifier = (uint8_t)xorshift32();
+    } else if (kind == 3) {
+        // Phantom state
+        memset(r, 0, sizeof(*r));
+        memset(r->keycode, 0x01, sizeof(r->keycode));
+    } else {
+        // Plausible typing: keep some held keys, add or release others
+        *r = last;
+        int slot = xorshift32() % 6;
+        uint32_t action = xorshift32() % 4;
+        r->keycode[slot] = action == 0 ? 0 : (uint8_t)(xorshift32() % 0x66);
+        if (action == 1) {
+            r->modifier = (uint8_t)xorshift32() & 0x22;  // Shift on/off
+        }
+    }
+    last = *r;
+}
+
+static void begin_pass(int n) {
+    pass = n;
+    cur = &results[n];
+    memset(cur, 0, sizeof(*cur));
+    cur->hash = 2166136261u;
+    rng = seed ? seed : 1;
+    done = 0;
+    memset(&last, 0, sizeof(last));
+
+    // Start both passes from the same state everywhere along the path.
+    // Random reports can hit the layout hotkeys, leave a compose sequence
+    // or a partial abbreviation open, and stop a macro that was playing.
+    keyq_flush();
+    keyboard_reset_state();
+    keyboard_set_layout(saved_layout);
+    keyboard_set_profile(PROFILE_NORMAL);
+    compose_reset();
+    abbrev_reset();
+    macro_stop();
+}
+
+void fuzz_start(uint32_t count, uint32_t start_seed) {
+    if (running) {
+        return;
+    }
+    iterations = count;
+    seed = start_seed;
+    saved_layout = keyboard_get_layout();
+
+    // The game path ignores muting; begin_pass keeps the live keyboard off it
+    saved_profile = keyboard_get_profile();
+    saved_abbrev = config.abbrev;
+    config.abbrev = 0;
+
+    output_set_muted(true);
+    output_set_tap(tap);
+    begin_pass(0);
+    running = true;
+}
+
+static void print_result(void) {
+    const fuzz_result_t *r = &results[0];
+    bool deterministic = results[0].hash == results[1].hash &&
+                         results[0].keys == results[1].keys;
+    bool ok = deterministic && r->bad_events == 0 && r->bad_codes == 0 &&
+              r->slow == 0;
+
+    printf("fuzz %s reports=%lu seed=%lu keys=%lu hash=%08lX max_events=%lu "
+           "max_us=%lu bad_events=%lu bad_codes=%lu slow=%lu deterministic=%s\n",
+           ok ? "PASS" : "FAIL", (unsigned long)r->reports,
+           (unsigned long)seed, (unsigned long)r->keys, (unsigned long)r->hash,
+           (unsigned long)r->max_events, (unsigned long)r->max_us,
+           (unsigned long)r->bad_events, (unsigned long)r->bad_codes,
+           (unsigned long)r->slow, deterministic ? "yes" : "no");
+}
+
+void fuzz_task(void) {
+    if (!running) {
+        return;
+    }
+
+    for (int i = 0; i < FUZZ_SLICE && done < iterations; i++, done++) {
+        hid_keyboard_report_t report;
+        next_report(&report);
+
+        report_keys = 0;
+        uint32_t start = time_us_32();
+        process_kbd_report(&report);
+        keyq_drain();
+        uint32_t elapsed = time_us_32() - start;
+
+        cur->reports++;
+        if (report_keys > cur->max_events) {
+            cur->max_events = report_keys;
+        }
+        if (report_keys > sizeof(report.keycode)) {
+            cur->bad_events++;
+        }
+        if (elapsed > cur->max_us) {
+            cur->max_us = elapsed;
+        }
+        if (elapsed > FUZZ_MAX_REPORT_US) {
+            cur->slow++;
+        }
+    }
+
+    if (done < iterations) {
+        return;
+    }
+    if (pass == 0) {
+        begin_pass(1);
+        return;
+    }
+
+    running = false;
+    keyboard_reset_state();
+    keyboard_set_layout(saved_layout);
+    compose_reset();
+    abbrev_reset();
+    output_set_tap(NULL);
+    output_set_muted(false);
+    keyboard_set_profile(saved_profile);
+    config.abbrev = saved_abbrev;
+    print_result();
+}
+
+// ---------------------------------------------------------------------------
+// Report descriptors
+// ---------------------------------------------------------------------------
+
+// 8 buttons, X/Y, with a report ID and a constant pad field
+static const uint8_t desc_template[] = {
+    0x05, 0x01, 0x09, 0x05, 0xA1, 0x01, 0x85, 0x01,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x08, 0x15, 0x00, 0x25, 0x01,
+    0x75, 0x01, 0x95, 0x08, 0x81, 0x02,
+    0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x15, 0x81, 0x25, 0x7F,
+    0x75, 0x08, 0x95, 0x02, 0x81, 0x02,
+    0x75, 0x08, 0x95, 0x01, 0x81, 0x03,
+    0xC0,
+};
+
+void fuzz_descriptors(uint32_t count, uint32_t start_seed) {
+    uint8_t desc[FUZZ_DESC_MAX];
+    uint8_t report[64];
+    hid_plan_t plan;
+    uint32_t bad = 0, slow = 0, fields = 0, max_us = 0;
+
+    rng = start_seed ? start_seed : 1;
+    for (uint32_t n = 0; n < count; n++) {
+        uint16_t len = sizeof(desc_template);
+        memcpy(desc, desc_template, len);
+
+        uint32_t kind = xorshift32() % 4;
+        uint32_t flips = 1 + xorshift32() % 8;
+        for (uint32_t i = 0; i < flips; i++) {
+            desc[xorshift32() % len] = (uint8_t)xorshift32();
+        }
+        if (kind == 1) {
+            len = (uint16_t)(xorshift32() % len);
+        } else if (kind == 2) {
+            uint16_t extra = (uint16_t)(xorshift32() % (FUZZ_DESC_MAX - len));
+            for (uint16_t i = 0; i < extra; i++) {
+                desc[len++] = (uint8_t)xorshift32();
+            }
+        }
+        for (size_t i = 0; i < sizeof(report); i++) {
+            report[i] = (uint8_t)xorshift32();
+        }
+
+        uint32_t start = time_us_32();
+        hid_parse_plan(desc, len, &plan);
+        uint32_t elapsed = time_us_32() - start;
+
+        if (elapsed > max_us) {
+            max_us = elapsed;
+        }
+        if (elapsed > FUZZ_MAX_DESC_US) {
+            slow++;
+        }
+        if (plan.field_count > HID_PLAN_FIELDS) {
+            bad++;
+            continue;
+        }
+        fields += plan.field_count;
+
+        uint16_t report_len = (uint16_t)(xorshift32() % sizeof(report));
+        for (int i = 0; i < plan.field_count; i++) {
+            const hid_field_t *f = &plan.fields[i];
+            int32_t v;
+            if (f->bit_size == 0 || f->bit_size > 32 || f->bit_offset + f->bit_size > 64 * 8) {
+                bad++;
+            }
+            hid_field_read(f, plan.report_ids, report, report_len, &v);
+        }
+    }
+
+    printf("fuzz desc %s descriptors=%lu seed=%lu fields=%lu max_us=%lu bad=%lu slow=%lu\n",
+           bad == 0 && slow == 0 ? "PASS" : "FAIL", (unsigned long)count,
+           (unsigned long)start_seed, (unsigned long)fields, (unsigned long)max_us,
+           (unsigned long)bad, (unsigned long)slow);
+}
@@ -0,0 +1,19 @@
+#ifndef _FUZZ_H_
+#define _FUZZ_H_
+
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Report fuzzer
+//
+// Pushes pseudo-random keyboard reports through process_kbd_report() with
+// the bus muted and checks invariants on every report. Runs in slices from
+// the main loop so USB servicing continues during a long run.
+// ---------------------------------------------------------------------------
+void fuzz_start(uint32_t iterations, uint32_t seed);
+void fuzz_task(void);
+
+// Parse mutated HID report descriptors (runs to completion)
+void fuzz_descriptors(uint32_t count, uint32_t seed);
+
+#endif
@@ -0,0 +1,320 @@
+/*
+ * USB gamepads and joysticks
+ *
+ * Button key assignments are stored as one config record,
+ * CONFIG_KEY_PAD_KEYS, holding one ASCII code per button (0 = none).
+ *
+ * PB outputs are the OR of all mounted pads, so two pads can share the
+ * buttons the way two joysticks on a Y cable would.
+ *
+ * A mouse in boot protocol has a fixed report layout and no descriptor
+ * worth parsing, so it gets a built-in plan. Its relative X/Y movement is
+ * summed into a 0-255 position that drives the paddles like a joystick.
+ *
+ * Parsed plans are cached by VID/PID, interface and descriptor length, so
+ * a pad coming back through a KVM switch or hub is decoded without
+ * walking its report descriptor again. TinyUSB still fetches the
+ * descriptor during enumeration.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "config.h"
+#include "gamepad.h"
+#include "keyq.h"
+#include "paddle.h"
+#include "stats.h"
+
+#define NO_FIELD    0xFF
+#define PLAN_CACHE_MAX  4
+
+typedef struct {
+    uint16_t vid;
+    uint16_t pid;
+    uint8_t instance;
+    uint16_t desc_len;          // 0 marks an unused entry
+    uint32_t used;              // LRU stamp
+    hid_plan_t plan;
+} plan_cache_t;
+
+static plan_cache_t plan_cache[PLAN_CACHE_MAX];
+static uint32_t plan_clock = 0;
+static uint32_t plan_hits = 0;
+static uint32_t plan_misses = 0;
+
+gamepad_t gamepads[GAMEPAD_MAX];
+
+static uint8_t button_keys[GAMEPAD_BUTTONS];
+
+// Boot protocol mouse report: buttons 1-3 in byte 0, X and Y in bytes 1-2
+static const hid_plan_t boot_mouse_plan = {
+    .application_page = HID_USAGE_PAGE_DESKTOP,
+    .application = HID_USAGE_DESKTOP_MOUSE,
+    .relative = true,
+    .field_count = 5,
+    .fields = {
+        { 0, 1, 0,  HID_USAGE_PAGE_BUTTON,  1,                   0,    1   },
+        { 0, 1, 1,  HID_USAGE_PAGE_BUTTON,  2,                   0,    1   },
+        { 0, 1, 2,  HID_USAGE_PAGE_BUTTON,  3,                   0,    1   },
+        { 0, 8, 8,  HID_USAGE_PAGE_DESKTOP, HID_USAGE_DESKTOP_X, -127, 127 },
+        { 0, 8, 16, HID_USAGE_PAGE_DESKTOP, HID_USAGE_DESKTOP_Y, -127, 127 },
+    },
+};
+
+static void load_keys(uint16_t key, const uint8_t *data, uint16_t len) {
+    (void)key;
+    memcpy(button_keys, data, len < sizeof(button_keys) ? len : sizeof(button_keys));
+}
+
+void gamepad_init(void) {
+    gpio_init_mask(PB_PIN_MASK);
+    gpio_set_dir_out_masked(PB_PIN_MASK);
+    gpio_put_masked(PB_PIN_MASK, 0);
+
+    config_for_each(CONFIG_KEY_PAD_KEYS, CONFIG_KEY_PAD_KEYS, load_keys);
+}
+
+// Parse the report descriptor, or copy the plan cached for this device
+static void load_plan(gamepad_t *p, uint8_t dev_addr, uint8_t instance,
+                      const uint8_t *desc, uint16_t desc_len) {
+    uint16_t vid = 0, pid = 0;
+    tuh_vid_pid_get(dev_addr, &vid, &pid);
+
+    plan_cache_t *c = &plan_cache[0];
+    for (int i = 0; i < PLAN_CACHE_MAX; i++) {
+        plan_cache_t *e = &plan_cache[i];
+        if (e->desc_len == desc_len && e->vid == vid && e->pid == pid &&
+            e->instance == instance) {
+            p->plan = e->plan;
+            e->used = ++plan_clock;
+            plan_hits++;
+            return;
+        }
+        if (e->used < c->used) {
+            c = e;
+        }
+    }
+    plan_misses++;
+
+    if (!hid_parse_plan(desc, desc_len, &p->plan)) {
+        printf("HID dev=%d: malformed report descriptor, using %d fields\n",
+               dev_addr, p->plan.field_count);
+        return;
+    }
+    if (desc_len) {
+        c->vid = vid;
+        c->pid = pid;
+        c->instance = instance;
+        c->desc_len = desc_len;
+        c->used = ++plan_clock;
+        c->plan = p->plan;
+    }
+}
+
+static gamepad_t *find(uint8_t dev_addr, uint8_t instance) {
+    for (int i = 0; i < GAMEPAD_MAX; i++) {
+        gamepad_t *p = &gamepads[i];
+        if (p->mounted && p->dev_addr == dev_addr && p->instance == instance) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static const char *kind(const gamepad_t *p) {
+    switch (p->plan.application) {
+    case HID_USAGE_DESKTOP_GAMEPAD: return "Gamepad";
+    case HID_USAGE_DESKTOP_MOUSE:   return "Mouse";
+    default:                        return "Joystick";
+    }
+}
+
+// Scale an absolute axis to 0-255 over its logical range
+static uint8_t paddle_value(const hid_field_t *f, int32_t v) {
+    if (f->logical_max <= f->logical_min || v <= f->logical_min) {
+        return 0;
+    }
+    if (v >= f->logical_max) {
+        return 255;
+    }
+    return (uint8_t)(((int64_t)v - f->logical_min) * 255 /
+                     ((int64_t)f->logical_max - f->logical_min));
+}
+
+static void update_pb(void) {
+    uint32_t pressed = 0;
+    for (int i = 0; i < GAMEPAD_MAX; i++) {
+        if (gamepads[i].mounted) {
+            pressed |= gamepads[i].buttons;
+        }
+    }
+    gpio_put_masked(PB_PIN_MASK, (pressed & ((1u << PB_PIN_COUNT) - 1)) << PB_PIN_BASE);
+}
+
+bool gamepad_mount(uint8_t dev_addr, uint8_t instance,
+                   const uint8_t *desc, uint16_t desc_len) {
+    gamepad_t *p = NULL;
+    for (int i = 0; i < GAMEPAD_MAX && !p; i++) {
+        if (!gamepads[i].mounted) {
+            p = &gamepads[i];
+        }
+    }
+    if (!p) {
+        return false;
+    }
+
+    memset(p, 0, sizeof(*p));
+    if (tuh_hid_interface_protocol(dev_addr, instance) == HID_ITF_PROTOCOL_MOUSE &&
+        tuh_hid_get_protocol(dev_addr, instance) == HID_PROTOCOL_BOOT) {
+        p->plan = boot_mouse_plan;
+    } else {
+        load_plan(p, dev_addr, instance, desc, desc_len);
+    }
+    // Usages 2, 4 and 5 mean mouse, joystick and gamepad on the Generic
+    // Desktop page only
+    if (p->plan.application_page != HID_USAGE_PAGE_DESKTOP ||
+        (p->plan.application != HID_USAGE_DESKTOP_JOYSTICK &&
+         p->plan.application != HID_USAGE_DESKTOP_GAMEPAD &&
+         p->plan.application != HID_USAGE_DESKTOP_MOUSE)) {
+        return false;
+    }
+
+    memset(p->button_field, NO_FIELD, sizeof(p->button_field));
+    memset(p->axis_field, NO_FIELD, sizeof(p->axis_field));
+    for (int a = 0; a < GAMEPAD_AXES; a++) {
+        p->axis[a] = p->plan.relative ? GAMEPAD_MOUSE_MID : 0;
+    }
+    for (int i = 0; i < p->plan.field_count; i++) {
+        const hid_field_t *f = &p->plan.fields[i];
+        if (f->usage_page == HID_USAGE_PAGE_BUTTON &&
+            f->usage >= 1 && f->usage <= GAMEPAD_BUTTONS) {
+            p->button_field[f->usage - 1] = (uint8_t)i;
+        } else if (f->usage_page == HID_USAGE_PAGE_DESKTOP &&
+                   f->usage >= HID_USAGE_DESKTOP_X &&
+                   f->usage < HID_USAGE_DESKTOP_X + GAMEPAD_AXES) {
+            p->axis_field[f->usage - HID_USAGE_DESKTOP_X] = (uint8_t)i;
+        }
+    }
+
+    p->mounted = true;
+    p->dev_addr = dev_addr;
+    p->instance = instance;
+    printf("%s connected (dev=%d, instance=%d, %d fields)\n",
+           kind(p), dev_addr, instance, p->plan.field_count);
+    return true;
+}
+
+void gamepad_umount(uint8_t dev_addr, uint8_t instance) {
+    gamepad_t *p = find(dev_addr, instance);
+    if (p) {
+        printf("%s disconnected (dev=%d, instance=%d)\n", kind(p), dev_addr, instance);
+        p->mounted = false;
+        update_pb();
+    }
+}
+
+void gamepad_detach_all(void) {
+    for (int i = 0; i < GAMEPAD_MAX; i++) {
+        gamepads[i].mounted = false;
+    }
+    update_pb();
+}
+
+bool gamepad_report(uint8_t dev_addr, uint8_t instance,
+                    const uint8_t *report, uint16_t len) {
+    gamepad_t *p = find(dev_addr, instance);
+    if (!p) {
+        return false;
+    }
+
+    // With report IDs a report may carry only some fields; the others keep
+    // their last value
+    uint16_t buttons = p->buttons;
+    for (int b = 0; b < GAMEPAD_BUTTONS; b++) {
+        int32_t v;
+        if (p->button_field[b] != NO_FIELD &&
+            hid_field_read(&p->plan.fields[p->button_field[b]], p->plan.report_ids,
+                           report, len, &v)) {
+            buttons = v ? buttons | (1u << b) : buttons & ~(1u << b);
+        }
+    }
+
+    uint16_t pressed = buttons & ~p->buttons;
+    p->buttons = buttons;
+    update_pb();
+
+    // Axis n drives paddle n; a mouse axis holds the summed position
+    for (int a = 0; a < GAMEPAD_AXES; a++) {
+        const hid_field_t *f;
+        int32_t v;
+        if (p->axis_field[a] == NO_FIELD) {
+            continue;
+        }
+        f = &p->plan.fields[p->axis_field[a]];
+        if (!hid_field_read(f, p->plan.report_ids, report, len, &v)) {
+            continue;
+        }
+        if (p->plan.relative) {
+            v += p->axis[a];
+            p->axis[a] = v < 0 ? 0 : v > 255 ? 255 : v;
+            paddle_set((uint8_t)a, (uint8_t)p->axis[a]);
+        } else {
+            p->axis[a] = v;
+            paddle_set((uint8_t)a, paddle_value(f, v));
+        }
+    }
+    p->reports++;
+    stats_pad_report();
+
+    for (int b = 0; pressed; b++, pressed >>= 1) {
+        if ((pressed & 1) && button_keys[b]) {
+            keyq_push(button_keys[b], 0);
+        }
+    }
+    return true;
+}
+
+bool gamepad_set_key(uint8_t button, uint8_t ascii) {
+    if (button < 1 || button > GAMEPAD_BUTTONS) {
+        return false;
+    }
+    button_keys[button - 1] = ascii;
+    return config_write(CONFIG_KEY_PAD_KEYS, button_keys, sizeof(button_keys));
+}
+
+void gamepad_print(void) {
+    bool any = false;
+    for (int i = 0; i < GAMEPAD_MAX; i++) {
+        const gamepad_t *p = &gamepads[i];
+        if (!p->mounted) {
+            continue;
+        }
+        any = true;
+        printf("dev %d.%d %s, %d fields%s, buttons %04X, x %ld y %ld, %lu reports\n",
+               p->dev_addr, p->instance, kind(p),
+               p->plan.field_count, p->plan.report_ids ? " (report IDs)" : "",
+               p->buttons, (long)p->axis[0], (long)p->axis[1],
+               (unsigned long)p->reports);
+    }
+    if (!any) {
+        printf("no gamepads or mice\n");
+    }
+    printf("plan cache: %lu hits, %lu misses\n", (unsigned long)plan_hits,
+           (unsigned long)plan_misses);
+
+    for (int b = 0; b < GAMEPAD_BUTTONS; b++) {
+        if (b < PB_PIN_COUNT || button_keys[b]) {
+            printf("button %2d:", b + 1);
+            if (b < PB_PIN_COUNT) {
+                printf(" PB%d (GP%d)", b, PB_PIN_BASE + b);
+            }
+            if (button_keys[b]) {
+                printf(" key 0x%02X", button_keys[b]);
+            }
+            printf("\n");
+        }
+    }
+}
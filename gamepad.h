@@ -0,0 +1,65 @@
+#ifndef _GAMEPAD_H_
+#define _GAMEPAD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hid_parse.h"
+
+// ---------------------------------------------------------------------------
+// USB gamepads and joysticks
+//
+// Any HID interface whose report descriptor declares a joystick or gamepad
+// application is decoded through a hid_parse plan. Buttons 1-3 drive the
+// Apple II pushbutton inputs PB0-PB2 directly from the report callback, in
+// one SIO write. Each button can additionally type a key. The X and Y axes
+// set paddles 0 and 1 (see paddle.h).
+//
+// Boot protocol mice are handled here too: buttons 1-3 act as pushbuttons
+// and their movement moves the paddles from a centred start.
+//
+// The Apple II reads a pushbutton as pressed when its input is high. With
+// the shift-key mod, PB2 is also driven by SHIFT on GP11: wire only one of
+// GP11 and GP14 to PB2.
+// ---------------------------------------------------------------------------
+#define PB_PIN_BASE         12      // GP12-GP14 = PB0-PB2
+#define PB_PIN_COUNT        3
+#define PB_PIN_MASK         (((1u << PB_PIN_COUNT) - 1) << PB_PIN_BASE)
+
+#define GAMEPAD_MAX         CFG_TUH_HID
+#define GAMEPAD_BUTTONS     16
+#define GAMEPAD_AXES        2       // X, Y
+#define GAMEPAD_MOUSE_MID   128
+
+typedef struct {
+    bool mounted;
+    uint8_t dev_addr;
+    uint8_t instance;
+    hid_plan_t plan;
+    uint8_t button_field[GAMEPAD_BUTTONS];  // Plan index, 0xFF if absent
+    uint8_t axis_field[GAMEPAD_AXES];
+    uint16_t buttons;                       // Bit n = button n + 1
+    int32_t axis[GAMEPAD_AXES];             // Mouse: position 0-255
+    uint32_t reports;
+} gamepad_t;
+
+extern gamepad_t gamepads[GAMEPAD_MAX];
+
+void gamepad_init(void);
+
+// Take the interface if it is a joystick/gamepad/mouse; true if taken
+bool gamepad_mount(uint8_t dev_addr, uint8_t instance,
+                   const uint8_t *desc, uint16_t desc_len);
+void gamepad_umount(uint8_t dev_addr, uint8_t instance);
+void gamepad_detach_all(void);
+
+// Decode a report; false if the interface is not a mounted gamepad
+bool gamepad_report(uint8_t dev_addr, uint8_t instance,
+                    const uint8_t *report, uint16_t len);
+
+// Make button (1-based) type 'ascii' when pressed, 0 to stop
+bool gamepad_set_key(uint8_t button, uint8_t ascii);
+
+void gamepad_print(void);
+
+#endif
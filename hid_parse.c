@@ -0,0 +1,259 @@
+/*
+ * HID report descriptor parser
+ *
+ * Short items only (long items are skipped). Global state: usage page,
+ * logical min/max, report size/count/ID, with a small push/pop stack.
+ * Local state: a usage list, or a usage minimum/maximum range, cleared
+ * after each main item. Bit offsets are tracked per report ID.
+ *
+ * Descriptors come from the device and are untrusted: every read is
+ * bounds-checked and field positions beyond HID_MAX_REPORT_BITS are
+ * dropped.
+ */
+
+#include <string.h>
+
+#include "hid_parse.h"
+
+#define HID_MAX_REPORT_BITS   (64 * 8)
+#define HID_USAGES_MAX        16
+#define HID_STACK_DEPTH       2
+#define HID_REPORT_IDS_MAX    8
+
+// Item tags, including the type bits
+#define ITEM_INPUT            0x80
+#define ITEM_OUTPUT           0x90
+#define ITEM_FEATURE          0xB0
+#define ITEM_COLLECTION       0xA0
+#define ITEM_END_COLLECTION   0xC0
+#define ITEM_USAGE_PAGE       0x04
+#define ITEM_LOGICAL_MIN      0x14
+#define ITEM_LOGICAL_MAX      0x24
+#define ITEM_REPORT_SIZE      0x74
+#define ITEM_REPORT_ID        0x84
+#define ITEM_REPORT_COUNT     0x94
+#define ITEM_PUSH             0xA4
+#define ITEM_POP              0xB4
+#define ITEM_USAGE            0x08
+#define ITEM_USAGE_MIN        0x18
+#define ITEM_USAGE_MAX        0x28
+
+#define MAIN_CONSTANT         0x01
+#define MAIN_VARIABLE         0x02
+#define MAIN_RELATIVE         0x04
+
+#define COLLECTION_APPLICATION  0x01
+
+typedef struct {
+    uint16_t usage_page;
+    int32_t logical_min;
+    int32_t logical_max;
+    uint8_t report_size;
+    uint8_t report_id;
+    uint16_t report_count;
+} globals_t;
+
+static bool wanted(uint16_t page, uint16_t usage) {
+    if (page == HID_USAGE_PAGE_BUTTON) {
+        return true;
+    }
+    return page == HID_USAGE_PAGE_DESKTOP &&
+           usage >= HID_USAGE_DESKTOP_X && usage <= HID_USAGE_DESKTOP_RZ;
+}
+
+bool hid_parse_plan(const uint8_t *desc, uint16_t len, hid_plan_t *plan) {
+    globals_t g, stack[HID_STACK_DEPTH];
+    int depth = 0;
+    uint32_t usages[HID_USAGES_MAX];    // Page in the high half if given
+    int usage_count = 0;
+    uint32_t usage_min = 0, usage_max = 0;
+    bool have_range = false;
+    uint8_t ids[HID_REPORT_IDS_MAX] = { 0 };
+    uint16_t offsets[HID_REPORT_IDS_MAX] = { 0 };
+    int id_count = 1;                   // Slot 0: report ID 0
+    int id_slot = 0;
+
+    memset(&g, 0, sizeof(g));
+    memset(plan, 0, sizeof(*plan));
+
+    uint16_t pos = 0;
+    while (pos < len) {
+        uint8_t prefix = desc[pos++];
+
+        if (prefix == 0xFE) {           // Long item: size byte, tag, data
+            if (pos + 2 > len || pos + 2 + desc[pos] > len) {
+                return false;
+            }
+            pos += 2 + desc[pos];
+            continue;
+        }
+
+        uint8_t size = prefix & 0x03;
+        if (size == 3) {
+            size = 4;
+        }
+        if (pos + size > len) {
+            return false;
+        }
+
+        uint32_t udata = 0;
+        for (int i = 0; i < size; i++) {
+            udata |= (uint32_t)desc[pos + i] << (8 * i);
+        }
+        int32_t sdata = (int32_t)udata;
+        if (size == 1) {
+            sdata = (int8_t)udata;
+        } else if (size == 2) {
+            sdata = (int16_t)udata;
+        }
+        pos += size;
+
+        uint8_t tag = prefix & 0xFC;
+        switch (tag) {
+        case ITEM_USAGE_PAGE:    g.usage_page = (uint16_t)udata; break;
+        case ITEM_LOGICAL_MIN:   g.logical_min = sdata; break;
+        case ITEM_LOGICAL_MAX:   g.logical_max = sdata; break;
+        case ITEM_REPORT_SIZE:   g.report_size = (uint8_t)(udata > 32 ? 32 : udata); break;
+        case ITEM_REPORT_COUNT:  g.report_count = (uint16_t)(udata > 0xFFFF ? 0xFFFF : udata); break;
+
+        case ITEM_REPORT_ID:
+            g.report_id = (uint8_t)udata;
+            plan->report_ids = true;
+            for (id_slot = 0; id_slot < id_count && ids[id_slot] != g.report_id; id_slot++) {
+            }
+            if (id_slot == id_count) {
+                if (id_count == HID_REPORT_IDS_MAX) {
+                    return false;
+                }
+                ids[id_count++] = g.report_id;
+            }
+            break;
+
+        case ITEM_PUSH:
+            if (depth == HID_STACK_DEPTH) {
+                return false;
+            }
+            stack[depth++] = g;
+            break;
+
+        case ITEM_POP:
+            if (depth == 0) {
+                return false;
+            }
+            g = stack[--depth];
+            for (id_slot = 0; id_slot < id_count && ids[id_slot] != g.report_id; id_slot++) {
+            }
+            if (id_slot == id_count) {
+                id_slot = 0;
+            }
+            break;
+
+        case ITEM_USAGE:
+            if (usage_count < HID_USAGES_MAX) {
+                usages[usage_count++] = size == 4 ? udata : (uint32_t)g.usage_page << 16 | udata;
+            }
+            break;
+        case ITEM_USAGE_MIN:
+            usage_min = size == 4 ? udata : (uint32_t)g.usage_page << 16 | udata;
+            break;
+        case ITEM_USAGE_MAX:
+            usage_max = size == 4 ? udata : (uint32_t)g.usage_page << 16 | udata;
+            have_range = true;
+            break;
+
+        case ITEM_COLLECTION:
+            if (udata == COLLECTION_APPLICATION && plan->application == 0 && usage_count) {
+                plan->application_page = (uint16_t)(usages[0] >> 16);
+                plan->application = (uint16_t)usages[0];
+            }
+            usage_count = 0;
+            have_range = false;
+            break;
+
+        case ITEM_INPUT:
+            // A zero-size item takes no bits, whatever its count
+            for (uint16_t i = 0; g.report_size && i < g.report_count; i++) {
+                uint16_t offset = offsets[id_slot];
+                if (offset + g.report_size > HID_MAX_REPORT_BITS) {
+                    break;
+                }
+                offsets[id_slot] = offset + g.report_size;
+
+                if ((udata & (MAIN_CONSTANT | MAIN_VARIABLE)) != MAIN_VARIABLE) {
+                    continue;
+                }
+
+                uint32_t usage;
+                if (have_range) {
+                    usage = usage_min + i;
+                    if (usage > usage_max) {
+                        continue;
+                    }
+                } else if (usage_count) {
+                    usage = usages[i < (uint16_t)usage_count ? i : usage_count - 1];
+                } else {
+                    continue;
+                }
+
+                uint16_t page = (uint16_t)(usage >> 16);
+                uint16_t id = (uint16_t)usage;
+                if (!wanted(page, id) || plan->field_count == HID_PLAN_FIELDS) {
+                    continue;
+                }
+
+                hid_field_t *f = &plan->fields[plan->field_count++];
+                f->report_id = g.report_id;
+                f->bit_size = g.report_size;
+                f->bit_offset = offset;
+                f->usage_page = page;
+                f->usage = id;
+                f->logical_min = g.logical_min;
+                f->logical_max = g.logical_max;
+                if (page == HID_USAGE_PAGE_DESKTOP && (udata & MAIN_RELATIVE)) {
+                    plan->relative = true;
+                }
+            }
+            // Like every main item, an input ends the local state
+            /* fall through */
+        case ITEM_OUTPUT:
+        case ITEM_FEATURE:
+        case ITEM_END_COLLECTION:
+            usage_count = 0;
+            have_range = false;
+            break;
+
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+bool hid_field_read(const hid_field_t *f, bool report_ids,
+                    const uint8_t *report, uint16_t len, int32_t *value) {
+    if (report_ids) {
+        if (len == 0 || report[0] != f->report_id) {
+            return false;
+        }
+        report++;
+        len--;
+    }
+
+    uint32_t end = (uint32_t)f->bit_offset + f->bit_size;
+    if (f->bit_size == 0 || end > (uint32_t)len * 8) {
+        return false;
+    }
+
+    uint32_t raw = 0;
+    for (uint32_t bit = 0; bit < f->bit_size; bit++) {
+        uint32_t at = f->bit_offset + bit;
+        raw |= (uint32_t)((report[at >> 3] >> (at & 7)) & 1) << bit;
+    }
+
+    // Sign-extend fields whose logical range is signed
+    if (f->logical_min < 0 && f->bit_size < 32 && (raw & (1u << (f->bit_size - 1)))) {
+        raw |= ~0u << f->bit_size;
+    }
+    *value = (int32_t)raw;
+    return true;
+}
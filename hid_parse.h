@@ -0,0 +1,60 @@
+#ifndef _HID_PARSE_H_
+#define _HID_PARSE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------
+// HID report descriptor parser
+//
+// Turns a report descriptor into a "plan": the position of every input
+// field this firmware can use (buttons and Generic Desktop axes), so
+// reports are decoded with shifts and masks instead of re-walking the
+// descriptor. Arrays, constant padding and other usage pages only advance
+// the bit position.
+// ---------------------------------------------------------------------------
+#define HID_PLAN_FIELDS     24
+
+#define HID_USAGE_PAGE_DESKTOP      0x01
+#define HID_USAGE_PAGE_BUTTON       0x09
+
+#define HID_USAGE_DESKTOP_POINTER   0x01
+#define HID_USAGE_DESKTOP_MOUSE     0x02
+#define HID_USAGE_DESKTOP_JOYSTICK  0x04
+#define HID_USAGE_DESKTOP_GAMEPAD   0x05
+#define HID_USAGE_DESKTOP_X         0x30
+#define HID_USAGE_DESKTOP_Y         0x31
+#define HID_USAGE_DESKTOP_Z         0x32
+#define HID_USAGE_DESKTOP_RX        0x33
+#define HID_USAGE_DESKTOP_RY        0x34
+#define HID_USAGE_DESKTOP_RZ        0x35
+
+typedef struct {
+    uint8_t report_id;          // 0 if the device uses no report IDs
+    uint8_t bit_size;
+    uint16_t bit_offset;        // From the start of the data, after the ID
+    uint16_t usage_page;
+    uint16_t usage;
+    int32_t logical_min;
+    int32_t logical_max;
+} hid_field_t;
+
+typedef struct {
+    uint16_t application_page;  // Usage page and usage of the first
+    uint16_t application;       // application collection
+    bool report_ids;
+    bool relative;              // Axes are relative (mouse)
+    uint8_t field_count;
+    hid_field_t fields[HID_PLAN_FIELDS];
+} hid_plan_t;
+
+// Build a plan from a report descriptor. Returns false on a malformed
+// descriptor; fields found up to that point are kept.
+bool hid_parse_plan(const uint8_t *desc, uint16_t len, hid_plan_t *plan);
+
+// Read a field from a report as received (including the report ID byte,
+// if any). Returns false if the report does not carry the field.
+bool hid_field_read(const hid_field_t *f, bool report_ids,
+                    const uint8_t *report, uint16_t len, int32_t *value);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef _KEYBOARD_H_
+#define _KEYBOARD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tusb.h"
+#include "layouts.h"
+
+// ---------------------------------------------------------------------------
+// Keyboard path entry points shared with the tooling modules
+// ---------------------------------------------------------------------------
+
+// Run one boot-protocol report through the full translation path
+void process_kbd_report(hid_keyboard_report_t const *report);
+
+// Translation and output stages, exposed for benchmarks
+uint8_t hid_to_ascii(uint8_t keycode, uint8_t modifier);
+bool is_new_key(uint8_t keycode, const hid_keyboard_report_t *prev);
+void output_key(uint8_t ascii);
+
+// Switch the layout used by hid_to_ascii(); takes effect on the next key
+void keyboard_set_layout(layout_id_t id);
+layout_id_t keyboard_get_layout(void);
+
+bool keyboard_caps_lock(void);
+void keyboard_set_caps_lock(bool on);
+
+// Forget the previous report and Caps Lock state
+void keyboard_reset_state(void);
+
+// Report handling profiles. PROFILE_GAME trades everything but
+// translation for the shortest report-to-STROBE path (Ctrl+Alt+G toggles).
+typedef enum {
+    PROFILE_NORMAL,
+    PROFILE_GAME,
+    PROFILE_COUNT
+} keyboard_profile_t;
+
+void keyboard_set_profile(keyboard_profile_t profile);
+keyboard_profile_t keyboard_get_profile(void);
+void keyboard_print_latency(void);
+
+// Drop all keyboards without waiting for umount callbacks (USB host
+// restart). Caps Lock is kept and pushed to the keyboards when they return.
+void keyboard_detach_all(void);
+
+// While muted, keys go through the whole path but no output (bus or
+// serial) is driven, nothing is logged per key, macros are not recorded
+// and Caps Lock changes are not sent to the keyboard LEDs (used by replay,
+// fuzzing and benchmarks)
+void output_set_muted(bool muted);
+
+// Optional observer called with every key handed to the output stage
+void output_set_tap(void (*tap)(uint8_t ascii));
+
+#endif
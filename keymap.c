@@ -0,0 +1,73 @@
+/*
+ * Keycode conversion
+ *
+ * The layout tables and Caps Lock state that hid_to_ascii() reads. Kept
+ * apart from main.c because it only needs TinyUSB's HID constants, so the
+ * host build (tools/host) can check translation without the SDK.
+ */
+
+#include <stddef.h>
+
+#include "keyboard.h"
+#include "compose.h"
+#include "layouts.h"
+
+static bool caps_lock = false;
+
+// Active layout tables, cached so translation is one load per key
+static layout_id_t layout_id = LAYOUT_US;
+static const uint8_t *ascii_normal = NULL;
+static const uint8_t *ascii_shift = NULL;
+
+void keyboard_set_layout(layout_id_t id) {
+    if (id >= LAYOUT_COUNT) {
+        return;
+    }
+    layout_id = id;
+    ascii_normal = layouts[id].normal;
+    ascii_shift = layouts[id].shift;
+}
+
+layout_id_t keyboard_get_layout(void) {
+    return layout_id;
+}
+
+bool keyboard_caps_lock(void) {
+    return caps_lock;
+}
+
+void keyboard_set_caps_lock(bool on) {
+    caps_lock = on;
+}
+
+uint8_t hid_to_ascii(uint8_t keycode, uint8_t modifier) {
+    if (keycode >= KEYCODE_TABLE_SIZE) {
+        return 0;
+    }
+
+    bool shift = (modifier & (KEYBOARD_MODIFIER_LEFTSHIFT |
+                              KEYBOARD_MODIFIER_RIGHTSHIFT)) != 0;
+    bool ctrl  = (modifier & (KEYBOARD_MODIFIER_LEFTCTRL |
+                              KEYBOARD_MODIFIER_RIGHTCTRL)) != 0;
+
+    // Caps Lock inverts shift for letters only. Letters are recognised by
+    // what the layout produces, since their keycodes move between layouts.
+    uint8_t base = ascii_normal[keycode];
+    bool is_letter = (base >= 'a' && base <= 'z');
+    if (caps_lock && is_letter) {
+        shift = !shift;
+    }
+
+    uint8_t ascii = shift ? ascii_shift[keycode] : base;
+
+    // Ctrl + letter produces 0x01 (Ctrl-A) through 0x1A (Ctrl-Z), Ctrl + one
+    // of @ [ \ ] ^ _ produces 0x00 and 0x1B-0x1F; anything else is unchanged
+    if (ctrl) {
+        uint8_t code = ctrl_code[ascii & 0x7F];
+        if (code) {
+            ascii = code;
+        }
+    }
+
+    return ascii;
+}
@@ -0,0 +1,70 @@
+/*
+ * Paced output queue
+ *
+ * Single producer / single consumer ring. Producers run in the USB callback
+ * or main loop tasks and the consumer is keyq_task(), all on core 0, so no
+ * locking is needed. A full queue drops the new key and counts it.
+ */
+
+#include "pico/stdlib.h"
+#include "keyboard.h"
+#include "keyq.h"
+#include "stats.h"
+
+typedef struct {
+    uint32_t delay_us;
+    uint8_t ascii;
+} keyq_entry_t;
+
+static keyq_entry_t ring[KEYQ_SIZE];
+static uint32_t head = 0;   // Next slot to write
+static uint32_t tail = 0;   // Next slot to read
+static uint32_t last_out_us = 0;
+
+bool keyq_push(uint8_t ascii, uint32_t delay_us) {
+    uint32_t depth = head - tail;
+    if (depth >= KEYQ_SIZE) {
+        stats_key_dropped();
+        return false;
+    }
+
+    keyq_entry_t *e = &ring[head & (KEYQ_SIZE - 1)];
+    e->ascii = ascii;
+    e->delay_us = delay_us;
+    head++;
+    stats_queue_depth(depth + 1);
+    return true;
+}
+
+uint32_t keyq_space(void) {
+    return KEYQ_SIZE - (head - tail);
+}
+
+void keyq_flush(void) {
+    tail = head;
+}
+
+void keyq_task(void) {
+    if (head == tail) {
+        return;
+    }
+
+    const keyq_entry_t *e = &ring[tail & (KEYQ_SIZE - 1)];
+    if (time_us_32() - last_out_us < e->delay_us) {
+        return;
+    }
+
+    uint8_t ascii = e->ascii;
+    tail++;
+    output_key(ascii);
+    last_out_us = time_us_32();
+}
+
+void keyq_drain(void) {
+    while (head != tail) {
+        uint8_t ascii = ring[tail & (KEYQ_SIZE - 1)].ascii;
+        tail++;
+        output_key(ascii);
+    }
+    last_out_us = time_us_32();
+}
@@ -0,0 +1,27 @@
+#ifndef _KEYQ_H_
+#define _KEYQ_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------
+// Paced output queue
+//
+// Keys produced by the USB callback, macro playback and other sources are
+// queued here and strobed onto the bus from the main loop, one per pass,
+// so the callback never waits on the bus. Each entry carries the minimum
+// time since the previous key left the queue.
+// ---------------------------------------------------------------------------
+#define KEYQ_SIZE   64      // Power of two
+
+bool keyq_push(uint8_t ascii, uint32_t delay_us);
+uint32_t keyq_space(void);
+void keyq_flush(void);
+
+// Output the next key if its delay has elapsed
+void keyq_task(void);
+
+// Output everything queued immediately, ignoring delays
+void keyq_drain(void);
+
+#endif
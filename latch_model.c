@@ -0,0 +1,142 @@
+/*
+ * Apple II keyboard latch model
+ *
+ * The modelled program alternates between windows where it polls the
+ * keyboard and periods where it is busy elsewhere:
+ *
+ *   |<------------- period ------------->|
+ *   |<-- window -->|                     |
+ *    poll poll poll     (busy, no polls)
+ *
+ * Polls inside a window are poll_us apart. After reading a key the program
+ * spends handle_us processing it (echo, scroll, interpreting) before it can
+ * poll again. Latch reads are resolved lazily when the next STROBE arrives,
+ * so the model costs nothing between keys.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "latch_model.h"
+
+// A key read more than one video frame after its STROBE counts as delayed
+#define LATCH_DELAY_THRESHOLD_US   16667
+
+typedef struct {
+    const char *name;
+    uint32_t period_us;
+    uint32_t window_us;
+    uint32_t poll_us;
+    uint32_t handle_us;
+} latch_pattern_t;
+
+static const latch_pattern_t patterns[LATCH_POLL_COUNT] = {
+    [LATCH_POLL_GETLN] = { "getln", 1,      1,     12, 2000 },
+    [LATCH_POLL_BASIC] = { "basic", 100000, 10000, 40,  500 },
+    [LATCH_POLL_GAME]  = { "game",  16667,  1,     1,     0 },
+};
+
+static const latch_pattern_t *pattern = &patterns[LATCH_POLL_GETLN];
+
+static bool full = false;           // Bit 7 of $C000
+static uint64_t loaded_us = 0;      // When the current key was strobed in
+static uint64_t busy_until_us = 0;  // Program still handling previous key
+
+static latch_model_counts_t counts;
+
+// First time at or after t that the modelled program reads $C000
+static uint64_t next_poll(uint64_t t) {
+    if (t < busy_until_us) {
+        t = busy_until_us;
+    }
+
+    uint64_t window_start = t - (t % pattern->period_us);
+    uint64_t offset = t - window_start;
+    if (offset < pattern->window_us) {
+        uint64_t aligned = (offset + pattern->poll_us - 1) / pattern->poll_us *
+                           pattern->poll_us;
+        if (aligned < pattern->window_us) {
+            return window_start + aligned;
+        }
+    }
+    return window_start + pattern->period_us;
+}
+
+// Settle the key in the latch given that nothing else was strobed in
+// before 'now': either the program read it, or it is still waiting.
+// Returns false if it is still unread.
+static bool settle(uint64_t now) {
+    uint64_t read_us = next_poll(loaded_us);
+    if (read_us >= now) {
+        return false;
+    }
+
+    uint32_t delay = (uint32_t)(read_us - loaded_us);
+    counts.delivered++;
+    counts.delay_total_us += delay;
+    if (delay > counts.delay_max_us) {
+        counts.delay_max_us = delay;
+    }
+    if (delay > LATCH_DELAY_THRESHOLD_US) {
+        counts.delayed++;
+    }
+    busy_until_us = read_us + pattern->handle_us;
+    full = false;
+    return true;
+}
+
+void latch_model_strobe(uint8_t ascii) {
+    (void)ascii;
+    uint64_t now = time_us_64();
+
+    // A key still unread when the next STROBE arrives is overwritten
+    if (full && !settle(now)) {
+        counts.lost++;
+    }
+    counts.strobes++;
+    full = true;
+    loaded_us = now;
+}
+
+bool latch_model_select(const char *name) {
+    for (int i = 0; i < LATCH_POLL_COUNT; i++) {
+        if (strcmp(name, patterns[i].name) == 0) {
+            pattern = &patterns[i];
+            memset(&counts, 0, sizeof(counts));
+            full = false;
+            busy_until_us = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+const latch_model_counts_t *latch_model_counts(void) {
+    if (full) {
+        settle(time_us_64());
+    }
+    return &counts;
+}
+
+bool latch_model_pending(void) {
+    return full;
+}
+
+void latch_model_print(void) {
+    latch_model_counts();
+
+    printf("pattern   %s (period %lu us, window %lu us, poll %lu us, handle %lu us)\n",
+           pattern->name, (unsigned long)pattern->period_us,
+           (unsigned long)pattern->window_us, (unsigned long)pattern->poll_us,
+           (unsigned long)pattern->handle_us);
+    printf("strobes   %lu\n", (unsigned long)counts.strobes);
+    printf("delivered %lu\n", (unsigned long)counts.delivered);
+    printf("lost      %lu\n", (unsigned long)counts.lost);
+    printf("in latch  %d\n", full ? 1 : 0);
+    printf("delayed   %lu (> %u us)\n", (unsigned long)counts.delayed,
+           LATCH_DELAY_THRESHOLD_US);
+    printf("delay     avg %lu us, max %lu us\n",
+           (unsigned long)(counts.delivered ? counts.delay_total_us / counts.delivered : 0),
+           (unsigned long)counts.delay_max_us);
+}
@@ -0,0 +1,39 @@
+#ifndef _LATCH_MODEL_H_
+#define _LATCH_MODEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------
+// Apple II keyboard latch model
+//
+// Mirrors the $C000/$C010 latch on the Apple II side: each STROBE loads the
+// latch, and a modelled program polls $C000 and clears it via $C010. A key
+// still in the latch when the next STROBE arrives is overwritten and lost.
+// ---------------------------------------------------------------------------
+typedef enum {
+    LATCH_POLL_GETLN,   // Monitor/BASIC GETLN: tight KEYIN loop, slow echo
+    LATCH_POLL_BASIC,   // Running BASIC program: keyboard checked in bursts
+    LATCH_POLL_GAME,    // Game reading the keyboard once per 60 Hz frame
+    LATCH_POLL_COUNT
+} latch_poll_t;
+
+typedef struct {
+    uint32_t strobes;
+    uint32_t delivered;
+    uint32_t lost;
+    uint32_t delayed;           // Read more than a video frame after STROBE
+    uint64_t delay_total_us;
+    uint32_t delay_max_us;
+} latch_model_counts_t;
+
+void latch_model_strobe(uint8_t ascii);
+bool latch_model_select(const char *name);
+
+// Counts so far, with the key in the latch settled up to now
+const latch_model_counts_t *latch_model_counts(void);
+bool latch_model_pending(void);
+
+void latch_model_print(void);
+
+#endif
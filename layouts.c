@@ -0,0 +1,172 @@
+/*
+ * Keyboard layouts
+ *
+ * A layout is described as a list of KEY(keycode, normal, shifted)
+ * entries. LAYOUT_US lists every key; the national layouts start from it
+ * and list only the keys that differ, so later entries override earlier
+ * ones. The descriptions are expanded twice by the preprocessor, once per
+ * table, so there is no parsing at runtime and lookup stays a single load.
+ *
+ * A 0 entry means the key produces nothing (e.g. a character with no
+ * 7-bit equivalent).
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tusb.h"
+#include "layouts.h"
+
+// ---------------------------------------------------------------------------
+// Apple II arrow key ASCII codes
+// ---------------------------------------------------------------------------
+#define APPLE_LEFT   0x08   // Ctrl-H
+#define APPLE_RIGHT  0x15   // Ctrl-U
+#define APPLE_DOWN   0x0A   // Ctrl-J (LF)
+#define APPLE_UP     0x0B   // Ctrl-K (VT)
+
+// ---------------------------------------------------------------------------
+// Layout descriptions
+// ---------------------------------------------------------------------------
+
+// clang-format off
+#define LAYOUT_US(KEY) \
+    KEY(0x04, 'a', 'A')  KEY(0x05, 'b', 'B')  KEY(0x06, 'c', 'C')  KEY(0x07, 'd', 'D') \
+    KEY(0x08, 'e', 'E')  KEY(0x09, 'f', 'F')  KEY(0x0A, 'g', 'G')  KEY(0x0B, 'h', 'H') \
+    KEY(0x0C, 'i', 'I')  KEY(0x0D, 'j', 'J')  KEY(0x0E, 'k', 'K')  KEY(0x0F, 'l', 'L') \
+    KEY(0x10, 'm', 'M')  KEY(0x11, 'n', 'N')  KEY(0x12, 'o', 'O')  KEY(0x13, 'p', 'P') \
+    KEY(0x14, 'q', 'Q')  KEY(0x15, 'r', 'R')  KEY(0x16, 's', 'S')  KEY(0x17, 't', 'T') \
+    KEY(0x18, 'u', 'U')  KEY(0x19, 'v', 'V')  KEY(0x1A, 'w', 'W')  KEY(0x1B, 'x', 'X') \
+    KEY(0x1C, 'y', 'Y')  KEY(0x1D, 'z', 'Z')  KEY(0x1E, '1', '!')  KEY(0x1F, '2', '@') \
+    KEY(0x20, '3', '#')  KEY(0x21, '4', '$')  KEY(0x22, '5', '%')  KEY(0x23, '6', '^') \
+    KEY(0x24, '7', '&')  KEY(0x25, '8', '*')  KEY(0x26, '9', '(')  KEY(0x27, '0', ')') \
+    KEY(0x28, '\r', '\r') KEY(0x29, 0x1B, 0x1B) KEY(0x2A, 0x7F, 0x7F) KEY(0x2B, '\t', '\t') \
+    KEY(0x2C, ' ', ' ')  KEY(0x2D, '-', '_')  KEY(0x2E, '=', '+')  KEY(0x2F, '[', '{') \
+    KEY(0x30, ']', '}')  KEY(0x31, '\\', '|') KEY(0x33, ';', ':')  KEY(0x34, '\'', '"') \
+    KEY(0x35, '`', '~')  KEY(0x36, ',', '<')  KEY(0x37, '.', '>')  KEY(0x38, '/', '?') \
+    KEY(0x4C, 0x7F, 0x7F) \
+    KEY(0x4F, APPLE_RIGHT, APPLE_RIGHT) KEY(0x50, APPLE_LEFT, APPLE_LEFT) \
+    KEY(0x51, APPLE_DOWN, APPLE_DOWN)   KEY(0x52, APPLE_UP, APPLE_UP)
+
+// UK (BS 4730: pound sign sends '#')
+#define LAYOUT_UK(KEY) LAYOUT_US(KEY) \
+    KEY(0x1F, '2', '"')  KEY(0x20, '3', '#')  KEY(0x34, '\'', '@') \
+    KEY(0x32, '#', '~')  KEY(0x35, '`', 0)    KEY(0x64, '\\', '|')
+
+// German QWERTZ (DIN 66003: ae oe ue sz = { | } ~, AE OE UE = [ \ ], section = @)
+#define LAYOUT_DE(KEY) LAYOUT_US(KEY) \
+    KEY(0x1C, 'z', 'Z')  KEY(0x1D, 'y', 'Y') \
+    KEY(0x1F, '2', '"')  KEY(0x20, '3', '@')  KEY(0x23, '6', '&')  KEY(0x24, '7', '/') \
+    KEY(0x25, '8', '(')  KEY(0x26, '9', ')')  KEY(0x27, '0', '=') \
+    KEY(0x2D, '~', '?')  KEY(0x2E, '\'', '`') KEY(0x2F, '}', ']')  KEY(0x30, '+', '*') \
+    KEY(0x31, '#', '\'') KEY(0x32, '#', '\'') KEY(0x33, '|', '\\') KEY(0x34, '{', '[') \
+    KEY(0x35, '^', 0)    KEY(0x36, ',', ';')  KEY(0x37, '.', ':')  KEY(0x38, '-', '_') \
+    KEY(0x64, '<', '>')
+
+// French AZERTY (ISO 646-FR: a-grave c-cedilla e-acute u-grave e-grave
+// = @ \ { | }, pound = #, section = ])
+#define LAYOUT_FR(KEY) LAYOUT_US(KEY) \
+    KEY(0x04, 'q', 'Q')  KEY(0x14, 'a', 'A')  KEY(0x1A, 'z', 'Z')  KEY(0x1D, 'w', 'W') \
+    KEY(0x33, 'm', 'M')  KEY(0x10, ',', '?') \
+    KEY(0x1E, '&', '1')  KEY(0x1F, '{', '2')  KEY(0x20, '"', '3')  KEY(0x21, '\'', '4') \
+    KEY(0x22, '(', '5')  KEY(0x23, '-', '6')  KEY(0x24, '}', '7')  KEY(0x25, '_', '8') \
+    KEY(0x26, '\\', '9') KEY(0x27, '@', '0')  KEY(0x2D, ')', 0)    KEY(0x2E, '=', '+') \
+    KEY(0x2F, '^', 0)    KEY(0x30, '$', '#')  KEY(0x31, '*', 0)    KEY(0x32, '*', 0) \
+    KEY(0x34, '|', '%')  KEY(0x35, 0, 0)      KEY(0x36, ';', '.')  KEY(0x37, ':', '/') \
+    KEY(0x38, '!', ']')  KEY(0x64, '<', '>')
+// clang-format on
+
+#define KEY_NORMAL(code, normal, shifted)  [code] = (normal),
+#define KEY_SHIFT(code, normal, shifted)   [code] = (shifted),
+
+// National layouts deliberately re-initialise keys from the US base
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+
+static const uint8_t us_normal[KEYCODE_TABLE_SIZE] = { LAYOUT_US(KEY_NORMAL) };
+static const uint8_t us_shift[KEYCODE_TABLE_SIZE]  = { LAYOUT_US(KEY_SHIFT)  };
+static const uint8_t uk_normal[KEYCODE_TABLE_SIZE] = { LAYOUT_UK(KEY_NORMAL) };
+static const uint8_t uk_shift[KEYCODE_TABLE_SIZE]  = { LAYOUT_UK(KEY_SHIFT)  };
+static const uint8_t de_normal[KEYCODE_TABLE_SIZE] = { LAYOUT_DE(KEY_NORMAL) };
+static const uint8_t de_shift[KEYCODE_TABLE_SIZE]  = { LAYOUT_DE(KEY_SHIFT)  };
+static const uint8_t fr_normal[KEYCODE_TABLE_SIZE] = { LAYOUT_FR(KEY_NORMAL) };
+static const uint8_t fr_shift[KEYCODE_TABLE_SIZE]  = { LAYOUT_FR(KEY_SHIFT)  };
+
+#pragma GCC diagnostic pop
+
+const keyboard_layout_t layouts[LAYOUT_COUNT] = {
+    [LAYOUT_US] = { "us", us_normal, us_shift },
+    [LAYOUT_UK] = { "uk", uk_normal, uk_shift },
+    [LAYOUT_DE] = { "de", de_normal, de_shift },
+    [LAYOUT_FR] = { "fr", fr_normal, fr_shift },
+};
+
+layout_id_t layout_find(const char *name) {
+    for (int i = 0; i < LAYOUT_COUNT; i++) {
+        if (strcmp(name, layouts[i].name) == 0) {
+            return (layout_id_t)i;
+        }
+    }
+    return LAYOUT_COUNT;
+}
+
+// ---------------------------------------------------------------------------
+// Verification
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    layout_id_t layout;
+    uint8_t keycode;
+    bool shift;
+    uint8_t expected;
+} layout_check_t;
+
+// Spot checks for keys each layout is known to move or remap
+static const layout_check_t checks[] = {
+    { LAYOUT_US, HID_KEY_A,          false, 'a'  },
+    { LAYOUT_US, HID_KEY_2,          true,  '@'  },
+    { LAYOUT_US, HID_KEY_ARROW_LEFT, false, 0x08 },
+    { LAYOUT_UK, HID_KEY_2,          true,  '"'  },
+    { LAYOUT_UK, HID_KEY_APOSTROPHE, true,  '@'  },
+    { LAYOUT_UK, HID_KEY_EUROPE_1,   false, '#'  },
+    { LAYOUT_UK, HID_KEY_EUROPE_2,   true,  '|'  },
+    { LAYOUT_DE, HID_KEY_Z,          false, 'y'  },
+    { LAYOUT_DE, 0x1C /* Y */,       true,  'Z'  },
+    { LAYOUT_DE, HID_KEY_SEMICOLON,  false, '|'  },
+    { LAYOUT_DE, HID_KEY_MINUS,      true,  '?'  },
+    { LAYOUT_DE, HID_KEY_SLASH,      false, '-'  },
+    { LAYOUT_FR, HID_KEY_A,          false, 'q'  },
+    { LAYOUT_FR, 0x14 /* Q */,       false, 'a'  },
+    { LAYOUT_FR, HID_KEY_SEMICOLON,  true,  'M'  },
+    { LAYOUT_FR, HID_KEY_1,          false, '&'  },
+    { LAYOUT_FR, HID_KEY_1,          true,  '1'  },
+    { LAYOUT_FR, HID_KEY_0,          false, '@'  },
+};
+
+bool layout_verify(void) {
+    bool ok = true;
+
+    for (int l = 0; l < LAYOUT_COUNT; l++) {
+        for (int kc = 0; kc < KEYCODE_TABLE_SIZE; kc++) {
+            if (layouts[l].normal[kc] >= 0x80 || layouts[l].shift[kc] >= 0x80) {
+                printf("Layout %s: keycode 0x%02X is not 7-bit\n",
+                       layouts[l].name, kc);
+                ok = false;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+        const layout_check_t *c = &checks[i];
+        const keyboard_layout_t *l = &layouts[c->layout];
+        uint8_t got = c->shift ? l->shift[c->keycode] : l->normal[c->keycode];
+        if (got != c->expected) {
+            printf("Layout %s: keycode 0x%02X%s gave 0x%02X, expected 0x%02X\n",
+                   l->name, c->keycode, c->shift ? "+shift" : "", got,
+                   c->expected);
+            ok = false;
+        }
+    }
+
+    return ok;
+}
@@ -0,0 +1,41 @@
+#ifndef _LAYOUTS_H_
+#define _LAYOUTS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------
+// Keyboard layouts
+//
+// Each layout is a pair of flat tables indexed by USB HID keycode, built by
+// the compiler from the descriptions in layouts.c. Characters outside 7-bit
+// ASCII use the ISO 646 national variant of that country (e.g. German
+// a-umlaut sends '{'), matching how 7-bit machines displayed them.
+// ---------------------------------------------------------------------------
+
+// Keycodes 0x00 - 0x64 (up to the ISO key next to left Shift)
+#define KEYCODE_TABLE_SIZE  0x65
+
+typedef enum {
+    LAYOUT_US,
+    LAYOUT_UK,
+    LAYOUT_DE,
+    LAYOUT_FR,
+    LAYOUT_COUNT
+} layout_id_t;
+
+typedef struct {
+    const char *name;
+    const uint8_t *normal;
+    const uint8_t *shift;
+} keyboard_layout_t;
+
+extern const keyboard_layout_t layouts[LAYOUT_COUNT];
+
+// Look up a layout by name, or LAYOUT_COUNT if unknown
+layout_id_t layout_find(const char *name);
+
+// Check every layout against its expected key spot checks; prints failures
+bool layout_verify(void);
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Keyboard LEDs
+ *
+ * Counters:
+ *   issued     SET_REPORT transfers started
+ *   coalesced  LED changes that did not need a transfer of their own,
+ *              per keyboard (e.g. three quick toggles -> one transfer,
+ *              two coalesced)
+ *   completed  transfers acknowledged by the keyboard
+ *   failed     transfers that could not be started or were not accepted;
+ *              both are retried on the next pass
+ */
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "devices.h"
+#include "keyboard.h"
+#include "leds.h"
+
+uint32_t leds_changes = 0;
+
+static struct {
+    uint32_t issued;
+    uint32_t coalesced;
+    uint32_t completed;
+    uint32_t failed;
+} counts;
+
+void leds_task(void) {
+    uint8_t wanted = keyboard_caps_lock() ? KEYBOARD_LED_CAPSLOCK : 0;
+    uint32_t changes = leds_changes;
+
+    for (int i = 0; i < KBD_DEVICE_MAX; i++) {
+        kbd_device_t *d = &kbd_devices[i];
+        if (!d->mounted || d->led_busy || d->led_changes_seen == changes) {
+            continue;
+        }
+
+        uint32_t covered = changes - d->led_changes_seen;
+
+        // Toggled back to what the keyboard already shows
+        if (d->led_sent == wanted) {
+            d->led_changes_seen = changes;
+            counts.coalesced += covered;
+            continue;
+        }
+
+        d->led_report = wanted;
+        d->led_busy = true;
+        d->led_sent_ms = to_ms_since_boot(get_absolute_time());
+        if (!tuh_hid_set_report(d->dev_addr, d->instance, 0,
+                                HID_REPORT_TYPE_OUTPUT, &d->led_report, 1)) {
+            // Control pipe busy (interval query, liveness probe); the
+            // change stays unseen and is retried
+            d->led_busy = false;
+            counts.failed++;
+            continue;
+        }
+        d->led_changes_seen = changes;
+        d->led_sent = wanted;
+        counts.issued++;
+        counts.coalesced += covered - 1;
+    }
+}
+
+void tuh_hid_set_report_complete_cb(uint8_t dev_addr, uint8_t instance,
+                                    uint8_t report_id, uint8_t report_type,
+                                    uint16_t len) {
+    (void)report_id;
+    (void)report_type;
+
+    kbd_device_t *d = kbd_device_find(dev_addr, instance);
+    if (!d) {
+        return;
+    }
+    d->led_busy = false;
+    if (len) {
+        counts.completed++;
+    } else {
+        // The keyboard state is unknown: send again on the next pass
+        d->led_sent = 0xFF;
+        d->led_changes_seen = leds_changes - 1;
+        counts.failed++;
+    }
+}
+
+void leds_print(void) {
+    printf("caps lock  %s\n", keyboard_caps_lock() ? "on" : "off");
+    printf("issued     %lu\n", (unsigned long)counts.issued);
+    printf("coalesced  %lu\n", (unsigned long)counts.coalesced);
+    printf("completed  %lu\n", (unsigned long)counts.completed);
+    printf("failed     %lu\n", (unsigned long)counts.failed);
+}
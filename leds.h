@@ -0,0 +1,23 @@
+#ifndef _LEDS_H_
+#define _LEDS_H_
+
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Keyboard LEDs
+//
+// Caps Lock changes only bump a counter in the report path. leds_task()
+// later sends each mounted keyboard its new LED state with an asynchronous
+// SET_REPORT, at most one transfer in flight per keyboard; toggles that
+// happen while a transfer is pending are folded into the next one.
+// ---------------------------------------------------------------------------
+extern uint32_t leds_changes;
+
+static inline void leds_changed(void) {
+    leds_changes++;
+}
+
+void leds_task(void);
+void leds_print(void);
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Main-loop latency tracer
+ *
+ * Both histograms use power-of-two buckets: bucket k counts intervals of
+ * 2^(k-1) to 2^k - 1 us, the last bucket everything longer. Site
+ * attribution costs one timer read per mark; a segment runs from one mark
+ * to the next, and the longest segment inside a gap names its culprit.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "looptrace.h"
+
+#define HIST_BUCKETS    20      // Last bucket: 2^18 us (262 ms) and up
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t hist[HIST_BUCKETS];
+} interval_stats_t;
+
+static interval_stats_t iter;
+static interval_stats_t usb_gap;
+
+static bool pass_seen = false;
+static bool usb_seen = false;
+static uint32_t last_pass_us;
+static uint32_t last_usb_us;
+
+// Current site and the heaviest site in the gap being measured
+static const char *site = "boot";
+static uint32_t site_start_us;
+static const char *gap_site = NULL;
+static uint32_t gap_site_us = 0;
+
+// Worst gap since clear
+static const char *worst_site = NULL;
+static uint32_t worst_site_us = 0;
+static bool worst_unreported = false;
+
+static void interval_clear(interval_stats_t *s) {
+    memset(s, 0, sizeof(*s));
+    s->min_us = UINT32_MAX;
+}
+
+static void interval_add(interval_stats_t *s, uint32_t us) {
+    s->count++;
+    if (us < s->min_us) {
+        s->min_us = us;
+    }
+    if (us > s->max_us) {
+        s->max_us = us;
+    }
+    uint32_t bucket = us ? 32 - __builtin_clz(us) : 0;
+    s->hist[bucket < HIST_BUCKETS ? bucket : HIST_BUCKETS - 1]++;
+}
+
+// Close the segment of the current site
+static void charge(uint32_t now) {
+    uint32_t segment = now - site_start_us;
+    if (segment >= gap_site_us) {
+        gap_site_us = segment;
+        gap_site = site;
+    }
+    site_start_us = now;
+}
+
+void looptrace_site(const char *s) {
+    charge(time_us_32());
+    site = s;
+}
+
+const char *looptrace_current_site(void) {
+    return site;
+}
+
+void looptrace_pass(void) {
+    uint32_t now = time_us_32();
+    if (pass_seen) {
+        interval_add(&iter, now - last_pass_us);
+    }
+    pass_seen = true;
+    last_pass_us = now;
+}
+
+void looptrace_usb(void) {
+    uint32_t now = time_us_32();
+    charge(now);
+
+    if (usb_seen) {
+        uint32_t gap = now - last_usb_us;
+        if (gap > usb_gap.max_us) {
+            worst_site = gap_site;
+            worst_site_us = gap_site_us;
+            worst_unreported = gap > LOOPTRACE_WARN_US;
+        }
+        interval_add(&usb_gap, gap);
+    }
+    usb_seen = true;
+    last_usb_us = now;
+
+    gap_site = NULL;
+    gap_site_us = 0;
+    site = "usb";
+}
+
+void looptrace_task(void) {
+    if (worst_unreported) {
+        worst_unreported = false;
+        printf("loop: USB not serviced for %lu us, %lu us of it in %s\n",
+               (unsigned long)usb_gap.max_us, (unsigned long)worst_site_us,
+               worst_site ? worst_site : "?");
+    }
+}
+
+void looptrace_clear(void) {
+    interval_clear(&iter);
+    interval_clear(&usb_gap);
+    pass_seen = false;
+    usb_seen = false;
+    gap_site = NULL;
+    gap_site_us = 0;
+    worst_site = NULL;
+    worst_site_us = 0;
+    worst_unreported = false;
+    site_start_us = time_us_32();
+}
+
+static void print_interval(const char *name, const interval_stats_t *s) {
+    if (s->count == 0) {
+        printf("%s: no samples\n", name);
+        return;
+    }
+    printf("%s: %lu samples, min %lu us, max %lu us\n", name,
+           (unsigned long)s->count, (unsigned long)s->min_us, (unsigned long)s->max_us);
+    for (int k = 0; k < HIST_BUCKETS; k++) {
+        if (s->hist[k] == 0) {
+            continue;
+        }
+        if (k == HIST_BUCKETS - 1) {
+            printf("  >= %7lu us %10lu\n", 1ul << (k - 1), (unsigned long)s->hist[k]);
+        } else {
+            printf("  <  %7lu us %10lu\n", 1ul << k, (unsigned long)s->hist[k]);
+        }
+    }
+}
+
+void looptrace_print(void) {
+    print_interval("loop pass", &iter);
+    print_interval("usb gap", &usb_gap);
+    if (worst_site) {
+        printf("worst usb gap: %lu us in %s\n", (unsigned long)worst_site_us, worst_site);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef _LOOPTRACE_H_
+#define _LOOPTRACE_H_
+
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Main-loop latency tracer
+//
+// Timestamps every scheduler pass and every USB host service and keeps the
+// distribution of both intervals. Time between two USB services is
+// charged to "sites": each scheduler task is a site, and code that may
+// block marks itself with LOOPTRACE_HERE(). The site that took the largest
+// share of the worst gap is kept with it, so a blocking call such as the
+// RESET pulse shows up by file and line.
+// ---------------------------------------------------------------------------
+#define LOOPTRACE_WARN_US   5000    // Report new worst USB gaps above this
+
+#define LOOPTRACE_STR2(x)   #x
+#define LOOPTRACE_STR(x)    LOOPTRACE_STR2(x)
+#define LOOPTRACE_HERE()    looptrace_site(__FILE__ ":" LOOPTRACE_STR(__LINE__))
+
+// Time from now on is spent in 'site' (a string literal)
+void looptrace_site(const char *site);
+
+// Site currently charged (for crash records)
+const char *looptrace_current_site(void);
+
+// Start of a scheduler pass
+void looptrace_pass(void);
+
+// Start of a USB host service
+void looptrace_usb(void);
+
+// Print warnings for new worst gaps (outside the USB path)
+void looptrace_task(void);
+
+void looptrace_print(void);
+void looptrace_clear(void);
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ * Keyboard macros
+ *
+ * Each key is stored as three bytes: the character and the milliseconds
+ * since the previous key (little endian, saturating at 65535). A slot is
+ * saved as one config record, so recording a macro costs one flash append.
+ *
+ * Playback never waits: macro_task() keeps at most MACRO_QUEUE_AHEAD keys
+ * in the output queue and returns, leaving the queue to apply the pacing.
+ * A macro counts as playing until its last key has left the queue, so a
+ * keypress or macro_stop() can still cut it short by flushing the queue.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "config.h"
+#include "keyq.h"
+#include "macro.h"
+
+#define MACRO_BYTES_PER_KEY   3
+
+// Keys kept queued ahead of the bus; a stop flushes no more than this
+#define MACRO_QUEUE_AHEAD     2
+
+typedef struct {
+    uint8_t keys[MACRO_MAX_KEYS * MACRO_BYTES_PER_KEY];
+    uint16_t len;   // In keys
+} macro_slot_t;
+
+static macro_slot_t slots[MACRO_SLOTS];
+
+static int recording = -1;
+static uint32_t last_key_ms = 0;
+
+static int playing = -1;
+static bool play_timed = false;
+static uint16_t play_index = 0;
+
+static void load_record(uint16_t key, const uint8_t *data, uint16_t len) {
+    int slot = key - CONFIG_KEY_MACRO_BASE;
+    if (slot < MACRO_SLOTS && len <= sizeof(slots[slot].keys) &&
+        len % MACRO_BYTES_PER_KEY == 0) {
+        memcpy(slots[slot].keys, data, len);
+        slots[slot].len = len / MACRO_BYTES_PER_KEY;
+    }
+}
+
+void macro_init(void) {
+    config_for_each(CONFIG_KEY_MACRO_BASE, CONFIG_KEY_MACRO_BASE + MACRO_SLOTS - 1,
+                    load_record);
+}
+
+bool macro_recording(void) {
+    return recording >= 0;
+}
+
+bool macro_playing(void) {
+    return playing >= 0;
+}
+
+void macro_record_toggle(int slot) {
+    if (slot < 0 || slot >= MACRO_SLOTS) {
+        return;
+    }
+
+    if (recording == slot) {
+        macro_slot_t *m = &slots[slot];
+        config_write(CONFIG_KEY_MACRO_BASE + slot, m->keys,
+                     m->len * MACRO_BYTES_PER_KEY);
+        printf("Macro %d saved (%u keys)\n", slot + 1, m->len);
+        recording = -1;
+        return;
+    }
+
+    macro_stop();
+    recording = slot;
+    slots[slot].len = 0;
+    last_key_ms = to_ms_since_boot(get_absolute_time());
+    printf("Macro %d recording\n", slot + 1);
+}
+
+void macro_record_key(uint8_t ascii) {
+    if (recording < 0) {
+        return;
+    }
+    macro_slot_t *m = &slots[recording];
+    if (m->len >= MACRO_MAX_KEYS) {
+        return;
+    }
+
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    uint32_t gap = now - last_key_ms;
+    if (gap > UINT16_MAX) {
+        gap = UINT16_MAX;
+    }
+    last_key_ms = now;
+
+    uint8_t *k = &m->keys[m->len * MACRO_BYTES_PER_KEY];
+    k[0] = ascii;
+    k[1] = gap & 0xFF;
+    k[2] = gap >> 8;
+    m->len++;
+}
+
+bool macro_play(int slot, bool timed) {
+    if (slot < 0 || slot >= MACRO_SLOTS || slots[slot].len == 0 ||
+        recording >= 0) {
+        return false;
+    }
+    playing = slot;
+    play_timed = timed;
+    play_index = 0;
+    return true;
+}
+
+void macro_stop(void) {
+    if (playing >= 0) {
+        playing = -1;
+        keyq_flush();
+    }
+}
+
+void macro_task(void) {
+    if (playing < 0) {
+        return;
+    }
+
+    const macro_slot_t *m = &slots[playing];
+    while (play_index < m->len && KEYQ_SIZE - keyq_space() < MACRO_QUEUE_AHEAD) {
+        const uint8_t *k = &m->keys[play_index * MACRO_BYTES_PER_KEY];
+        uint32_t delay_us = config.pace_us;
+        if (play_timed && play_index > 0) {
+            delay_us = (k[1] | (k[2] << 8)) * 1000u;
+        }
+        keyq_push(k[0], delay_us);
+        play_index++;
+    }
+
+    if (play_index >= m->len && keyq_space() == KEYQ_SIZE) {
+        playing = -1;
+    }
+}
+
+void macro_print(void) {
+    for (int i = 0; i < MACRO_SLOTS; i++) {
+        printf("%d: %3u keys %s\"", i + 1, slots[i].len,
+               i == recording ? "(recording) " : i == playing ? "(playing) " : "");
+        for (int k = 0; k < slots[i].len; k++) {
+            uint8_t c = slots[i].keys[k * MACRO_BYTES_PER_KEY];
+            if (c >= 0x20 && c < 0x7F) {
+                putchar(c);
+            } else {
+                printf("^%c", (c & 0x1F) + '@');
+            }
+        }
+        printf("\"\n");
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef _MACRO_H_
+#define _MACRO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------
+// Keyboard macros
+//
+// MACRO_SLOTS slots of up to MACRO_MAX_KEYS characters each, recorded from
+// the translated key stream together with the time between keys. Playback
+// feeds the paced output queue from the main loop, either at the pacing
+// set by the "pace_us" setting or with the recorded timing.
+// ---------------------------------------------------------------------------
+#define MACRO_SLOTS      4
+#define MACRO_MAX_KEYS   128
+
+void macro_init(void);
+void macro_task(void);
+
+// Start recording into 'slot', or stop and save if already recording it
+void macro_record_toggle(int slot);
+
+// Called with every translated key while recording
+void macro_record_key(uint8_t ascii);
+
+bool macro_play(int slot, bool timed);
+void macro_stop(void);
+bool macro_recording(void);
+bool macro_playing(void);
+void macro_print(void);
+
+#endif
@@ -22,11 +22,38 @@
 #include "hardware/gpio.h"
 #include "tusb.h"
 
+#include "bus_trace.h"
+#include "compose.h"
+#include "config.h"
+#include "crashlog.h"
+#include "console.h"
+#include "devices.h"
+#include "keyboard.h"
+#include "keyq.h"
+#include "latch_model.h"
+#include "layouts.h"
+#include "looptrace.h"
+#include "leds.h"
+#include "macro.h"
+#include "abbrev.h"
+#include "bench.h"
+#include "fuzz.h"
+#include "gamepad.h"
+#include "paddle.h"
+#include "remap.h"
+#include "replay.h"
+#include "sched.h"
+#include "serial_out.h"
+#include "stackmon.h"
+#include "stats.h"
+#include "supervisor.h"
+
 // ---------------------------------------------------------------------------
 // Pin definitions
 // ---------------------------------------------------------------------------
 #define DATA_PIN_BASE    2      // GP2-GP8
 #define DATA_PIN_COUNT   7
+#define DATA_PIN_MASK    (((1u << DATA_PIN_COUNT) - 1) << DATA_PIN_BASE)
 #define STROBE_PIN       9      // GP9 - active high
 #define RESET_PIN        10     // GP10 - active high
 #define SHIFT_PIN        11     // GP11 - high when Shift held
@@ -35,53 +62,35 @@
 // ---------------------------------------------------------------------------
 // Timing
 // ---------------------------------------------------------------------------
-#define STROBE_DURATION_US   100     // ~100us to match original AY-5-3600
-#define RESET_DURATION_MS    250     // Power-on reset hold time
-#define LED_BLINK_MS         500     // LED blink half-period while searching
-
-// ---------------------------------------------------------------------------
-// Apple II arrow key ASCII codes
-// ---------------------------------------------------------------------------
-#define APPLE_LEFT   0x08   // Ctrl-H
-#define APPLE_RIGHT  0x15   // Ctrl-U
-#define APPLE_DOWN   0x0A   // Ctrl-J (LF)
-#define APPLE_UP     0x0B   // Ctrl-K (VT)
-
-// ---------------------------------------------------------------------------
-// HID keycode to ASCII lookup tables
-// Indexed by USB HID keycode (0x00 - 0x52)
-// ---------------------------------------------------------------------------
-
-// clang-format off
-static const uint8_t keycode_to_ascii[] = {
-//  0x_0  0x_1  0x_2  0x_3  0x_4  0x_5  0x_6  0x_7  0x_8  0x_9  0x_A  0x_B  0x_C  0x_D  0x_E  0x_F
-    0,    0,    0,    0,    'a',  'b',  'c',  'd',  'e',  'f',  'g',  'h',  'i',  'j',  'k',  'l',  // 0x00
-    'm',  'n',  'o',  'p',  'q',  'r',  's',  't',  'u',  'v',  'w',  'x',  'y',  'z',  '1',  '2',  // 0x10
-    '3',  '4',  '5',  '6',  '7',  '8',  '9',  '0', '\r', 0x1B, 0x7F, '\t',  ' ',  '-',  '=',  '[',  // 0x20
-    ']', '\\',   0,   ';', '\'',  '`',  ',',  '.',  '/',   0,    0,    0,    0,    0,    0,    0,    // 0x30
-    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  0x7F,   0,    0,    0x15, // 0x40
-    0x08, 0x0A, 0x0B,                                                                               // 0x50
-};
+// STROBE, RESET and LED timings are settings, see config.h
+#define DATA_SETUP_US        1       // Data settle time before STROBE rises
 
-static const uint8_t keycode_to_ascii_shift[] = {
-//  0x_0  0x_1  0x_2  0x_3  0x_4  0x_5  0x_6  0x_7  0x_8  0x_9  0x_A  0x_B  0x_C  0x_D  0x_E  0x_F
-    0,    0,    0,    0,    'A',  'B',  'C',  'D',  'E',  'F',  'G',  'H',  'I',  'J',  'K',  'L',  // 0x00
-    'M',  'N',  'O',  'P',  'Q',  'R',  'S',  'T',  'U',  'V',  'W',  'X',  'Y',  'Z',  '!',  '@',  // 0x10
-    '#',  '$',  '%',  '^',  '&',  '*',  '(',  ')', '\r', 0x1B, 0x7F, '\t',  ' ',  '_',  '+',  '{',  // 0x20
-    '}',  '|',   0,   ':',  '"',  '~',  '<',  '>',  '?',   0,    0,    0,    0,    0,    0,    0,    // 0x30
-    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  0x7F,   0,    0,    0x15, // 0x40
-    0x08, 0x0A, 0x0B,                                                                               // 0x50
-};
-// clang-format on
-
-#define KEYCODE_TABLE_SIZE (sizeof(keycode_to_ascii))
+// Reported in every keycode slot when too many keys are held (phantom state)
+#define HID_KEYCODE_ERROR_ROLLOVER  0x01
 
 // ---------------------------------------------------------------------------
 // State
 // ---------------------------------------------------------------------------
 static hid_keyboard_report_t prev_report = {0};
-static bool caps_lock = false;
+static uint32_t prev_raw[2] = {0};      // Last fully processed raw report
 static bool kbd_connected = false;
+static bool output_muted = false;
+static void (*output_tap)(uint8_t ascii) = NULL;
+
+// Report arrival to STROBE rise for the first key of each report, per
+// profile; the normal path includes the output queue and main loop
+static uint32_t report_arrival_us = 0;
+static bool report_latency_pending = false;
+
+static struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} latency[PROFILE_COUNT] = {
+    { 0, UINT32_MAX, 0, 0 },
+    { 0, UINT32_MAX, 0, 0 },
+};
 
 // ---------------------------------------------------------------------------
 // GPIO
@@ -116,62 +125,134 @@ static void init_gpio(void) {
     gpio_put(LED_PIN, 0);
 }
 
+// Record the current state of the Apple II side pins in the bus trace
+static void trace_bus(void) {
+    uint32_t pins = gpio_get_all();
+    uint16_t sample = (pins >> DATA_PIN_BASE) & BUS_TRACE_DATA_MASK;
+    if (pins & (1u << STROBE_PIN)) sample |= BUS_TRACE_STROBE;
+    if (pins & (1u << RESET_PIN))  sample |= BUS_TRACE_RESET;
+    if (pins & (1u << SHIFT_PIN))  sample |= BUS_TRACE_SHIFT;
+    bus_trace_record(sample);
+}
+
 static void pulse_strobe(void) {
     gpio_put(STROBE_PIN, 1);
-    sleep_us(STROBE_DURATION_US);
+    trace_bus();
+    sleep_us(config.strobe_us);
     gpio_put(STROBE_PIN, 0);
+    trace_bus();
 }
 
 static void pulse_reset(void) {
+    stats_reset();
+    if (output_muted) {
+        return;
+    }
     gpio_put(RESET_PIN, 1);
-    sleep_ms(RESET_DURATION_MS);
+    trace_bus();
+    LOOPTRACE_HERE();
+    sleep_ms(config.reset_ms);
     gpio_put(RESET_PIN, 0);
+    trace_bus();
 }
 
-static void output_key(uint8_t ascii) {
-    // Set 7-bit ASCII value on GP2-GP8
-    for (int i = 0; i < DATA_PIN_COUNT; i++) {
-        gpio_put(DATA_PIN_BASE + i, (ascii >> i) & 1);
+void keyboard_detach_all(void) {
+    kbd_device_remove_all();
+    kbd_connected = false;
+    memset(&prev_report, 0, sizeof(prev_report));
+    memset(prev_raw, 0, sizeof(prev_raw));
+}
+
+void output_set_muted(bool muted) {
+    // LED reports are held while muted; bring the LEDs in line once after
+    if (output_muted && !muted) {
+        leds_changed();
     }
-    pulse_strobe();
+    output_muted = muted;
 }
 
-// ---------------------------------------------------------------------------
-// Keycode conversion
-// ---------------------------------------------------------------------------
+void output_set_tap(void (*tap)(uint8_t ascii)) {
+    output_tap = tap;
+}
 
-static uint8_t hid_to_ascii(uint8_t keycode, uint8_t modifier) {
-    if (keycode >= KEYCODE_TABLE_SIZE) {
-        return 0;
+void keyboard_reset_state(void) {
+    memset(&prev_report, 0, sizeof(prev_report));
+    memset(prev_raw, 0, sizeof(prev_raw));
+    if (keyboard_caps_lock()) {
+        keyboard_set_caps_lock(false);
+        if (!output_muted) {
+            leds_changed();
+        }
     }
+}
 
-    bool shift = (modifier & (KEYBOARD_MODIFIER_LEFTSHIFT |
-                              KEYBOARD_MODIFIER_RIGHTSHIFT)) != 0;
-    bool ctrl  = (modifier & (KEYBOARD_MODIFIER_LEFTCTRL |
-                              KEYBOARD_MODIFIER_RIGHTCTRL)) != 0;
+static void latency_add(keyboard_profile_t p, uint32_t us) {
+    latency[p].count++;
+    latency[p].total_us += us;
+    if (us < latency[p].min_us) {
+        latency[p].min_us = us;
+    }
+    if (us > latency[p].max_us) {
+        latency[p].max_us = us;
+    }
+}
 
-    // Caps Lock inverts shift for letters only
-    bool is_letter = (keycode >= HID_KEY_A && keycode <= HID_KEY_Z);
-    if (caps_lock && is_letter) {
-        shift = !shift;
+// ---------------------------------------------------------------------------
+// Output backends
+//
+// output_key() hands each key to every backend enabled in the outputs
+// setting. A backend may hold the caller for one STROBE pulse at most;
+// anything slower (serial) buffers and finishes from its own task.
+// ---------------------------------------------------------------------------
+typedef struct {
+    uint32_t mask;              // OUTPUT_* bit in config.outputs
+    void (*put)(uint8_t ascii);
+} output_backend_t;
+
+static void bus_output(uint8_t ascii) {
+    uint32_t start = time_us_32();
+
+    // Set 7-bit ASCII value on GP2-GP8 in a single SIO write so all data
+    // lines change together
+    gpio_put_masked(DATA_PIN_MASK, (uint32_t)ascii << DATA_PIN_BASE);
+    trace_bus();
+    sleep_us(DATA_SETUP_US);
+    latch_model_strobe(ascii);
+    if (report_latency_pending) {
+        report_latency_pending = false;
+        latency_add(PROFILE_NORMAL, time_us_32() - report_arrival_us);
     }
+    pulse_strobe();
 
-    uint8_t ascii = shift ? keycode_to_ascii_shift[keycode]
-                          : keycode_to_ascii[keycode];
+    stats_bus_busy(time_us_32() - start);
+}
 
-    // Ctrl + letter: produce 0x01 (Ctrl-A) through 0x1A (Ctrl-Z)
-    if (ctrl && is_letter) {
-        ascii = (keycode - HID_KEY_A) + 1;
-    }
+static const output_backend_t outputs[] = {
+    { OUTPUT_BUS,    bus_output     },
+    { OUTPUT_SERIAL, serial_out_put },
+};
+
+#define OUTPUT_COUNT (sizeof(outputs) / sizeof(outputs[0]))
 
-    return ascii;
+void output_key(uint8_t ascii) {
+    if (output_tap) {
+        output_tap(ascii);
+    }
+    if (!output_muted) {
+        for (unsigned i = 0; i < OUTPUT_COUNT; i++) {
+            if (config.outputs & outputs[i].mask) {
+                outputs[i].put(ascii);
+            }
+        }
+    }
+    stats_key_emitted();
 }
 
 // ---------------------------------------------------------------------------
 // HID report processing
 // ---------------------------------------------------------------------------
 
-static bool is_new_key(uint8_t keycode, const hid_keyboard_report_t *prev) {
+bool is_new_key(uint8_t keycode, const hid_keyboard_report_t *prev) {
     for (int i = 0; i < 6; i++) {
         if (prev->keycode[i] == keycode) {
             return false;
@@ -180,17 +261,61 @@ static bool is_new_key(uint8_t keycode, const hid_keyboard_report_t *prev) {
     return true;
 }
 
-static void process_kbd_report(hid_keyboard_report_t const *report) {
-    // Output Shift state on GP11 for Apple II game connector
-    bool shift_held = (report->modifier & (KEYBOARD_MODIFIER_LEFTSHIFT |
-                                           KEYBOARD_MODIFIER_RIGHTSHIFT)) != 0;
+// Drive SHIFT (GP11 on the game connector) from a remapped modifier byte
+static void update_shift(uint8_t modifier) {
+    bool shift_held = (modifier & (KEYBOARD_MODIFIER_LEFTSHIFT |
+                                   KEYBOARD_MODIFIER_RIGHTSHIFT)) != 0;
     gpio_put(SHIFT_PIN, shift_held);
+    trace_bus();
+}
+
+void process_kbd_report(hid_keyboard_report_t const *raw) {
+    stats_report();
+    crashlog_report(raw);
+
+    // Fast path: with the keycode slots unchanged there is nothing new to
+    // press, so a repeated report needs no work and a modifier-only change
+    // only moves SHIFT. Compared as two words: byte 0 is the modifier,
+    // byte 1 reserved, bytes 2..7 the keycodes. The report buffer may be
+    // unaligned, hence memcpy.
+    uint32_t words[2];
+    memcpy(words, raw, sizeof(words));
+    if (words[1] == prev_raw[1] &&
+        ((words[0] ^ prev_raw[0]) & 0xFFFF0000u) == 0) {
+        stats_fast_path();
+        if (words[0] != prev_raw[0]) {
+            stats_modifier_only();
+            prev_report.modifier = remap_report_modifier(raw);
+            update_shift(prev_report.modifier);
+            prev_raw[0] = words[0];
+        }
+        return;
+    }
+
+    // Phantom state: more keys are down than the report can carry, so every
+    // slot reads ErrorRollOver. Count it as a drop and keep the previous
+    // report, otherwise every held key would look new once rollover clears.
+    if (raw->keycode[0] == HID_KEYCODE_ERROR_ROLLOVER) {
+        stats_key_dropped();
+        return;
+    }
+
+    // Everything below, including prev_report, sees the remapped report
+    hid_keyboard_report_t mapped;
+    remap_report(raw, &mapped);
+    hid_keyboard_report_t const *report = &mapped;
+
+    update_shift(report->modifier);
+    bool to_game = false;
 
     // Toggle Caps Lock on new press
     for (int i = 0; i < 6; i++) {
         if (report->keycode[i] == HID_KEY_CAPS_LOCK &&
             is_new_key(HID_KEY_CAPS_LOCK, &prev_report)) {
-            caps_lock = !caps_lock;
+            keyboard_set_caps_lock(!keyboard_caps_lock());
+            if (!output_muted) {
+                leds_changed();
+            }
         }
     }
 
@@ -204,23 +329,232 @@ static void process_kbd_report(hid_keyboard_report_t const *report) {
             continue;
         }
 
+        // Any key interrupts macro playback and is otherwise ignored
+        if (macro_playing()) {
+            macro_stop();
+            continue;
+        }
+
+        bool ctrl  = (report->modifier & (KEYBOARD_MODIFIER_LEFTCTRL |
+                                          KEYBOARD_MODIFIER_RIGHTCTRL)) != 0;
+        bool alt   = (report->modifier & (KEYBOARD_MODIFIER_LEFTALT |
+                                          KEYBOARD_MODIFIER_RIGHTALT)) != 0;
+        bool shift = (report->modifier & (KEYBOARD_MODIFIER_LEFTSHIFT |
+                                          KEYBOARD_MODIFIER_RIGHTSHIFT)) != 0;
+        bool fkey  = keycode >= HID_KEY_F1 && keycode < HID_KEY_F1 + MACRO_SLOTS;
+
+        // Ctrl + F1..F4 = play macro, Ctrl + Shift + F1..F4 = record/stop.
+        // Not available to muted tooling runs, which must not touch flash.
+        if (ctrl && !alt && fkey && !output_muted) {
+            if (shift) {
+                macro_record_toggle(keycode - HID_KEY_F1);
+            } else {
+                macro_play(keycode - HID_KEY_F1, config.macro_timed);
+            }
+            continue;
+        }
+
+        // Ctrl + Alt + G = game mode, from the next report. Switched after
+        // this report is stored so the game path starts from it, G held.
+        if (ctrl && alt && keycode == HID_KEY_G && !output_muted) {
+            to_game = true;
+            continue;
+        }
+
+        // Ctrl + Alt + F1..F4 = select keyboard layout
+        if (ctrl && alt && keycode >= HID_KEY_F1 &&
+            keycode < HID_KEY_F1 + LAYOUT_COUNT) {
+            keyboard_set_layout((layout_id_t)(keycode - HID_KEY_F1));
+            if (!output_muted) {
+                config_set(CONFIG_KEY_LAYOUT, keyboard_get_layout());
+                printf("Layout: %s\n", layouts[keyboard_get_layout()].name);
+            }
+            continue;
+        }
+
         // Ctrl + Print Screen = system reset
-        if (keycode == HID_KEY_PRINT_SCREEN &&
-            (report->modifier & (KEYBOARD_MODIFIER_LEFTCTRL |
-                                 KEYBOARD_MODIFIER_RIGHTCTRL))) {
-            printf("RESET triggered (Ctrl+PrtSc)\n");
+        if (keycode == HID_KEY_PRINT_SCREEN && ctrl) {
+            if (!output_muted) {
+                printf("RESET triggered (Ctrl+PrtSc)\n");
+            }
             pulse_reset();
             continue;
         }
 
+        // Menu key starts a compose sequence
+        if (keycode == HID_KEY_APPLICATION) {
+            compose_start();
+            continue;
+        }
+
         uint8_t ascii = hid_to_ascii(keycode, report->modifier);
+        if (ascii && compose_state) {
+            ascii = compose_feed(ascii);
+        }
         if (ascii) {
-            printf("Key: 0x%02X\n", ascii);
-            output_key(ascii);
+            if (!output_muted) {
+                printf("Key: 0x%02X\n", ascii);
+            }
+            if (!output_muted) {
+                macro_record_key(ascii);
+            }
+            if (!(config.abbrev && abbrev_filter(ascii))) {
+                keyq_push(ascii, 0);
+            }
         }
     }
 
     prev_report = *report;
+    prev_raw[0] = words[0];
+    prev_raw[1] = words[1];
+
+    if (to_game) {
+        keyboard_set_profile(PROFILE_GAME);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Game mode
+//
+// The report callback goes through report_handler, so switching profile is
+// one pointer store. The game handler translates through a table built at
+// switch time from the current layout, Shift, Ctrl and Caps Lock state,
+// and strobes keys onto the bus (and into the serial ring, if enabled) from
+// the callback itself: no queue, remap, compose, macros, per-key logging,
+// stats, bus trace or latch model. Ctrl+PrtSc still resets the Apple II;
+// Ctrl+Alt+G switches back.
+// ---------------------------------------------------------------------------
+typedef void (*report_handler_t)(uint8_t dev_addr, uint8_t instance,
+                                 hid_keyboard_report_t const *report);
+
+static uint8_t game_table[2][2][KEYCODE_TABLE_SIZE];    // [ctrl][shift][keycode]
+static hid_keyboard_report_t game_prev = {0};
+static keyboard_profile_t profile = PROFILE_NORMAL;
+
+static void game_output(uint8_t ascii) {
+    if (config.outputs & OUTPUT_SERIAL) {
+        serial_out_put(ascii);
+    }
+    if (!(config.outputs & OUTPUT_BUS)) {
+        return;
+    }
+    gpio_put_masked(DATA_PIN_MASK, (uint32_t)ascii << DATA_PIN_BASE);
+    busy_wait_us_32(DATA_SETUP_US);
+    gpio_put(STROBE_PIN, 1);
+    if (report_latency_pending) {
+        report_latency_pending = false;
+        latency_add(PROFILE_GAME, time_us_32() - report_arrival_us);
+    }
+    busy_wait_us_32(config.strobe_us);
+    gpio_put(STROBE_PIN, 0);
+}
+
+static void game_report(uint8_t dev_addr, uint8_t instance,
+                        hid_keyboard_report_t const *report) {
+    // Activity for the supervisor's liveness probe; poll timing statistics
+    // are left to the normal path
+    kbd_device_t *d = kbd_device_find(dev_addr, instance);
+    if (d) {
+        d->last_report_us = time_us_64();
+    }
+
+    report_latency_pending = true;
+    if (report->keycode[0] == HID_KEYCODE_ERROR_ROLLOVER) {
+        return;
+    }
+
+    uint8_t modifier = report->modifier;
+    bool shift = (modifier & (KEYBOARD_MODIFIER_LEFTSHIFT |
+                              KEYBOARD_MODIFIER_RIGHTSHIFT)) != 0;
+    bool ctrl  = (modifier & (KEYBOARD_MODIFIER_LEFTCTRL |
+                              KEYBOARD_MODIFIER_RIGHTCTRL)) != 0;
+    gpio_put(SHIFT_PIN, shift);
+
+    const uint8_t *table = game_table[ctrl][shift];
+    for (int i = 0; i < 6; i++) {
+        uint8_t keycode = report->keycode[i];
+        if (keycode >= KEYCODE_TABLE_SIZE || !is_new_key(keycode, &game_prev)) {
+            continue;
+        }
+        if (ctrl && keycode == HID_KEY_G &&
+            (modifier & (KEYBOARD_MODIFIER_LEFTALT | KEYBOARD_MODIFIER_RIGHTALT))) {
+            game_prev = *report;
+            keyboard_set_profile(PROFILE_NORMAL);
+            return;
+        }
+        if (ctrl && keycode == HID_KEY_PRINT_SCREEN) {
+            pulse_reset();
+            continue;
+        }
+        if (table[keycode]) {
+            game_output(table[keycode]);
+        }
+    }
+    game_prev = *report;
+}
+
+static void normal_report(uint8_t dev_addr, uint8_t instance,
+                          hid_keyboard_report_t const *report) {
+    kbd_device_t *d = kbd_device_find(dev_addr, instance);
+    if (d) {
+        kbd_device_report_timing(d);
+    }
+
+    uint32_t space = keyq_space();
+    process_kbd_report(report);
+    report_latency_pending = keyq_space() < space;
+}
+
+static report_handler_t report_handler = normal_report;
+
+void keyboard_set_profile(keyboard_profile_t p) {
+    if (p == profile) {
+        return;
+    }
+
+    if (p == PROFILE_GAME) {
+        for (int kc = 0; kc < KEYCODE_TABLE_SIZE; kc++) {
+            for (int c = 0; c < 2; c++) {
+                uint8_t mod = c ? KEYBOARD_MODIFIER_LEFTCTRL : 0;
+                game_table[c][0][kc] = hid_to_ascii((uint8_t)kc, mod);
+                game_table[c][1][kc] = hid_to_ascii((uint8_t)kc,
+                                                    mod | KEYBOARD_MODIFIER_LEFTSHIFT);
+            }
+        }
+        macro_stop();
+        keyq_flush();
+        // The last raw report: game_report compares unremapped reports
+        memcpy(&game_prev, prev_raw, sizeof(game_prev));
+        report_handler = game_report;
+    } else {
+        // Keys still held stay "old" for the normal path
+        memcpy(prev_raw, &game_prev, sizeof(prev_raw));
+        remap_report(&game_prev, &prev_report);
+        report_handler = normal_report;
+    }
+    report_latency_pending = false;
+    profile = p;
+    printf("Profile: %s\n", p == PROFILE_GAME ? "game" : "normal");
+}
+
+keyboard_profile_t keyboard_get_profile(void) {
+    return profile;
+}
+
+void keyboard_print_latency(void) {
+    static const char *const names[PROFILE_COUNT] = { "normal", "game" };
+    printf("profile: %s\n", names[profile]);
+    printf("report to STROBE    keys    min    avg    max (us)\n");
+    for (int p = 0; p < PROFILE_COUNT; p++) {
+        if (latency[p].count == 0) {
+            printf("%-16s %7d      -      -      -\n", names[p], 0);
+            continue;
+        }
+        printf("%-16s %7lu %6lu %6lu %6lu\n", names[p],
+               (unsigned long)latency[p].count, (unsigned long)latency[p].min_us,
+               (unsigned long)(latency[p].total_us / latency[p].count),
+               (unsigned long)latency[p].max_us);
+    }
 }
 
 // ---------------------------------------------------------------------------
@@ -229,9 +563,6 @@ static void process_kbd_report(hid_keyboard_report_t const *report) {
 
 void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance,
                       uint8_t const *desc_report, uint16_t desc_len) {
-    (void)desc_report;
-    (void)desc_len;
-
     uint8_t const itf_protocol = tuh_hid_interface_protocol(dev_addr, instance);
 
     if (itf_protocol == HID_ITF_PROTOCOL_KEYBOARD) {
@@ -239,7 +570,27 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance,
         kbd_connected = true;
         gpio_put(LED_PIN, 1);
 
-        // Request boot protocol for fixed-format reports
+        // Track the keyboard; its LEDs are brought in line with Caps Lock
+        // on the next leds_task() pass
+        kbd_device_t *d = kbd_device_add(dev_addr, instance);
+        if (d) {
+            d->led_changes_seen = leds_changes - 1;
+            d->protocol = tuh_hid_get_protocol(dev_addr, instance);
+            if (d->protocol != HID_PROTOCOL_BOOT) {
+                printf("Warning: keyboard did not accept boot protocol\n");
+            }
+        }
+
+        // Start polling before any descriptor work so the first keystroke
+        // after a KVM switch is not held up behind it
+        if (!tuh_hid_receive_report(dev_addr, instance)) {
+            printf("Error: failed to request HID report\n");
+        }
+        if (d) {
+            kbd_device_query_interval(d);
+        }
+        supervisor_keyboard_mounted();
+    } else if (gamepad_mount(dev_addr, instance, desc_report, desc_len)) {
         if (!tuh_hid_receive_report(dev_addr, instance)) {
             printf("Error: failed to request HID report\n");
         }
@@ -247,19 +598,25 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance,
 }
 
 void tuh_hid_umount_cb(uint8_t dev_addr, uint8_t instance) {
-    (void)dev_addr;
-    (void)instance;
-    printf("Keyboard disconnected\n");
-    kbd_connected = false;
+    if (!kbd_device_find(dev_addr, instance)) {
+        gamepad_umount(dev_addr, instance);
+        return;
+    }
+    printf("Keyboard disconnected (dev=%d, instance=%d)\n", dev_addr, instance);
+    kbd_device_remove(dev_addr, instance);
+    kbd_connected = kbd_device_any_mounted();
     memset(&prev_report, 0, sizeof(prev_report));
+    memset(prev_raw, 0, sizeof(prev_raw));
 }
 
 void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance,
                                 uint8_t const *report, uint16_t len) {
-    if (tuh_hid_interface_protocol(dev_addr, instance) == HID_ITF_PROTOCOL_KEYBOARD) {
-        if (len >= sizeof(hid_keyboard_report_t)) {
-            process_kbd_report((hid_keyboard_report_t const *)report);
-        }
+    if (len >= sizeof(hid_keyboard_report_t) &&
+        tuh_hid_interface_protocol(dev_addr, instance) == HID_ITF_PROTOCOL_KEYBOARD) {
+        report_arrival_us = time_us_32();
+        report_handler(dev_addr, instance, (hid_keyboard_report_t const *)report);
+    } else {
+        gamepad_report(dev_addr, instance, report, len);
     }
 
     // Continue receiving reports
@@ -267,32 +624,84 @@ void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance,
 }
 
 // ---------------------------------------------------------------------------
-// Main
+// Main loop
 // ---------------------------------------------------------------------------
 
+// Blink LED while waiting for keyboard; solid on when connected
+static void usb_task(void) {
+    looptrace_usb();
+    tuh_task();
+}
+
+static void blink_task(void) {
+    if (!kbd_connected) {
+        uint32_t t = to_ms_since_boot(get_absolute_time());
+        gpio_put(LED_PIN, (t / config.led_blink_ms) % 2);
+    }
+}
+
+// Budgets are what each task is expected to need per call. The known
+// exceptions show up as overruns: a RESET pulse (keyq/macro paths call
+// pulse_reset()), config compaction erasing a flash sector, and long
+// console commands such as bench.
+static const sched_task_t tasks[] = {
+    // name      run              priority                period  budget  deadline
+    { "usb",     usb_task,        SCHED_PRIO_CRITICAL,        0,    500,    1000 },
+    { "keyq",    keyq_task,       SCHED_PRIO_NORMAL,          0,    250,    2000 },
+    { "serial",  serial_out_task, SCHED_PRIO_NORMAL,          0,     50,   10000 },
+    { "super",   supervisor_task, SCHED_PRIO_NORMAL,          0,     50,   10000 },
+    { "leds",    leds_task,       SCHED_PRIO_NORMAL,          0,    100,   10000 },
+    { "macro",   macro_task,      SCHED_PRIO_NORMAL,          0,    100,   10000 },
+    { "replay",  replay_task,     SCHED_PRIO_NORMAL,          0,    500,   10000 },
+    { "console", console_task,    SCHED_PRIO_BACKGROUND,   1000,   2000,   50000 },
+    { "config",  config_task,     SCHED_PRIO_BACKGROUND,   1000,   2000,  100000 },
+    { "fuzz",    fuzz_task,       SCHED_PRIO_BACKGROUND,      0,  20000,  100000 },
+    { "stats",   stats_task,      SCHED_PRIO_BACKGROUND,  10000,     50,  100000 },
+    { "blink",   blink_task,      SCHED_PRIO_BACKGROUND,  10000,     50,  100000 },
+    { "loop",    looptrace_task,  SCHED_PRIO_BACKGROUND,  10000,   5000,  100000 },
+};
+
+#define TASK_COUNT (sizeof(tasks) / sizeof(tasks[0]))
+
 int main(void) {
+    stackmon_init();
     stdio_init_all();
     init_gpio();
 
     printf("SB Mini II Keyboard Controller\n");
+    config_load();
+    crashlog_init();
+    keyboard_set_layout((layout_id_t)config.layout);
+    remap_init();
+    gamepad_init();
+    paddle_init();
+    serial_out_init();
+    macro_init();
+    abbrev_init();
+    compose_init();
+    if (!layout_verify()) {
+        printf("Warning: layout table check failed\n");
+    }
 
     // Power-on reset pulse
     printf("Power-on reset...\n");
     pulse_reset();
 
+    supervisor_init();
+
+    // Keyboards are switched to boot protocol while being configured, so
+    // reports arrive in the fixed 8-byte format process_kbd_report() expects
+    tuh_hid_set_default_protocol(HID_PROTOCOL_BOOT);
+
     // Initialize TinyUSB host
     tusb_init();
 
     printf("Waiting for keyboard...\n");
 
+    looptrace_clear();
+    sched_init(tasks, TASK_COUNT);
     while (true) {
-        tuh_task();
-
-        // Blink LED while waiting for keyboard; solid on when connected
-        if (!kbd_connected) {
-            uint32_t t = to_ms_since_boot(get_absolute_time());
-            gpio_put(LED_PIN, (t / LED_BLINK_MS) % 2);
-        }
+        sched_pass();
     }
 
     return 0;
@@ -0,0 +1,97 @@
+/*
+ * Paddle emulation on PIO
+ *
+ * Pulse lengths for all 256 values are computed once at boot, in state
+ * machine cycles, so paddle_set() is a table lookup and two register
+ * writes. Writing the TX FIFO from the CPU while the state machine pulls
+ * from it needs no lock: the FIFO is cleared and refilled with the newest
+ * count, and a trigger that lands in between reuses the previous count.
+ */
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/pio.h"
+#include "paddle.h"
+#include "paddle_model.h"
+#include "paddle.pio.h"
+
+static PIO pio = pio0;
+static uint sm[PADDLE_COUNT];
+static bool ready;
+
+static uint32_t sys_hz;
+static uint32_t counts[PADDLE_VALUES];
+static uint8_t values[PADDLE_COUNT];
+
+void paddle_init(void) {
+    sys_hz = clock_get_hz(clk_sys);
+    paddle_model_counts(sys_hz, counts);
+
+    // Idle high; the PTRIG strobe pulls it low
+    gpio_init(PADDLE_TRIG_PIN);
+    gpio_set_dir(PADDLE_TRIG_PIN, GPIO_IN);
+    gpio_pull_up(PADDLE_TRIG_PIN);
+
+    if (!pio_can_add_program(pio, &paddle_program)) {
+        printf("Paddles: no PIO program space\n");
+        return;
+    }
+    uint offset = pio_add_program(pio, &paddle_program);
+    for (int i = 0; i < PADDLE_COUNT; i++) {
+        int claimed = pio_claim_unused_sm(pio, false);
+        if (claimed < 0) {
+            printf("Paddles: no free state machine\n");
+            return;
+        }
+        sm[i] = (uint)claimed;
+        paddle_program_init(pio, sm[i], offset, PADDLE_TRIG_PIN, PADDLE_PIN_BASE + i);
+    }
+    ready = true;
+
+    for (int i = 0; i < PADDLE_COUNT; i++) {
+        paddle_set((uint8_t)i, 128);
+    }
+}
+
+void paddle_set(uint8_t paddle, uint8_t value) {
+    if (!ready || paddle >= PADDLE_COUNT) {
+        return;
+    }
+    values[paddle] = value;
+    pio_sm_clear_fifos(pio, sm[paddle]);
+    pio_sm_put(pio, sm[paddle], counts[value]);
+}
+
+bool paddle_check(void) {
+    if (!sys_hz) {
+        printf("Paddles not initialised\n");
+        return false;
+    }
+
+    int64_t worst;
+    uint32_t worst_value;
+    uint32_t bad = paddle_model_check(sys_hz, counts, &worst, &worst_value);
+
+    printf("PREAD model: %lu/%d values read back, worst margin %ld ns at value %lu\n",
+           (unsigned long)(PADDLE_VALUES - bad), PADDLE_VALUES,
+           (long)(worst / 1000), (unsigned long)worst_value);
+    return bad == 0;
+}
+
+void paddle_print(void) {
+    if (!ready) {
+        printf("Paddles not running\n");
+        return;
+    }
+    printf("trigger GP%d (%s)\n", PADDLE_TRIG_PIN, gpio_get(PADDLE_TRIG_PIN) ? "idle" : "low");
+    for (int i = 0; i < PADDLE_COUNT; i++) {
+        uint64_t ps = paddle_model_cycles_to_ps(sys_hz, counts[values[i]] + PADDLE_PIO_CYCLES);
+        uint32_t ns = (uint32_t)(ps / 1000);
+        printf("PDL%d (GP%d): value %3u, pulse %lu.%02lu us (%lu cycles)\n",
+               i, PADDLE_PIN_BASE + i, values[i],
+               (unsigned long)(ns / 1000), (unsigned long)(ns % 1000 / 10),
+               (unsigned long)counts[values[i]]);
+    }
+}
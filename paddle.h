@@ -0,0 +1,36 @@
+#ifndef _PADDLE_H_
+#define _PADDLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------
+// Paddle emulation
+//
+// The Apple II reads a paddle by strobing PTRIG ($C070), which starts the
+// 558 timers, then counting in PREAD until the timer output PDLn goes low.
+// Here a PIO state machine per paddle watches the trigger and holds its
+// output high for a precomputed number of cycles, so PREAD counts exactly
+// the paddle value. paddle_set() can be called from the report callback at
+// any time: it replaces the state machine's pending count, and the new
+// value takes effect from the next trigger.
+//
+// The outputs replace the 558 timer outputs, not the PDL pins of the game
+// connector (those are the timers' resistor inputs).
+// ---------------------------------------------------------------------------
+#define PADDLE_TRIG_PIN     15      // /C07X, low while PTRIG is accessed
+#define PADDLE_PIN_BASE     16      // GP16-GP17 = PDL0-PDL1
+#define PADDLE_COUNT        2
+
+void paddle_init(void);
+
+// Set the value (0-255) PREAD will return for paddle n
+void paddle_set(uint8_t paddle, uint8_t value);
+
+// Run every value through a model of PREAD and print the timing margins;
+// false if any value would read back wrong
+bool paddle_check(void);
+
+void paddle_print(void);
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * Paddle timing model
+ *
+ * Times are in picoseconds so one 14.31818 MHz tick (69.841 ns) and one
+ * 125 MHz state machine cycle (8 ns) are both exact enough to compare.
+ */
+
+#include "paddle_model.h"
+
+// Apple II timing in 14.31818 MHz ticks: a CPU cycle is 14 ticks, except
+// the last cycle of each 65-cycle scan line, which is stretched to 16
+#define TICK_PS             69841
+#define CYCLE_TICKS         14
+#define LINE_CYCLES         65
+#define LINE_TICKS          (LINE_CYCLES * CYCLE_TICKS + 2)
+
+// PREAD ($FB1E) is LDA PTRIG / LDY #0 / NOP / NOP, then a loop of
+// LDA PADDL0,X / BPL / INY / BNE. The first PDLn sample is 10 cycles after
+// the trigger and each later one 11 cycles on; Y ends up as the number of
+// samples that saw the timer still running.
+#define PREAD_FIRST         10
+#define PREAD_LOOP          11
+
+// Pulse end aimed at for a value: halfway between the last sample that
+// must see the timer running and the first that must see it stopped,
+// using the average cycle length
+static uint64_t target_ps(uint32_t value) {
+    return (uint64_t)(2 * PREAD_FIRST - PREAD_LOOP + 2 * PREAD_LOOP * value) *
+           LINE_TICKS * TICK_PS / (2 * LINE_CYCLES);
+}
+
+uint64_t paddle_model_cycles_to_ps(uint32_t sys_hz, uint64_t cycles) {
+    return cycles * 1000000000000ull / sys_hz;
+}
+
+void paddle_model_counts(uint32_t sys_hz, uint32_t counts[PADDLE_VALUES]) {
+    for (uint32_t v = 0; v < PADDLE_VALUES; v++) {
+        uint64_t cycles = (target_ps(v) * sys_hz + 500000000000ull) / 1000000000000ull;
+        counts[v] = cycles > PADDLE_PIO_CYCLES ? (uint32_t)(cycles - PADDLE_PIO_CYCLES) : 0;
+    }
+}
+
+// Time of sample n after the trigger: earliest and latest, depending on how
+// many stretched cycles fall within the first n cycles
+static uint64_t sample_early_ps(uint32_t n) {
+    uint32_t cycles = PREAD_FIRST + PREAD_LOOP * n;
+    return (uint64_t)(cycles * CYCLE_TICKS + (cycles / LINE_CYCLES) * 2) * TICK_PS;
+}
+
+static uint64_t sample_late_ps(uint32_t n) {
+    uint32_t cycles = PREAD_FIRST + PREAD_LOOP * n;
+    return (uint64_t)(cycles * CYCLE_TICKS +
+                      ((cycles + LINE_CYCLES - 1) / LINE_CYCLES) * 2) * TICK_PS;
+}
+
+uint32_t paddle_model_check(uint32_t sys_hz, const uint32_t counts[PADDLE_VALUES],
+                            int64_t *worst_ps, uint32_t *worst_value) {
+    uint32_t bad = 0;
+    int64_t worst = INT64_MAX;
+    uint32_t worst_v = 0;
+    for (uint32_t v = 0; v < PADDLE_VALUES; v++) {
+        uint64_t end_min = paddle_model_cycles_to_ps(sys_hz, counts[v] + PADDLE_PIO_CYCLES);
+        uint64_t end_max = paddle_model_cycles_to_ps(sys_hz, counts[v] + PADDLE_PIO_CYCLES +
+                                                             PADDLE_PIO_JITTER);
+
+        // PREAD returns v if sample v-1 still sees the output high and
+        // sample v sees it low
+        int64_t margin = (int64_t)sample_early_ps(v) - (int64_t)end_max;
+        if (v > 0) {
+            int64_t before = (int64_t)end_min - (int64_t)sample_late_ps(v - 1);
+            if (before < margin) {
+                margin = before;
+            }
+        }
+        if (margin <= 0) {
+            bad++;
+        }
+        if (margin < worst) {
+            worst = margin;
+            worst_v = v;
+        }
+    }
+    *worst_ps = worst;
+    *worst_value = worst_v;
+    return bad;
+}
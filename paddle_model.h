@@ -0,0 +1,35 @@
+#ifndef _PADDLE_MODEL_H_
+#define _PADDLE_MODEL_H_
+
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Paddle timing model
+//
+// Turns paddle values into pulse lengths for the PIO program and checks
+// them against bounds on when PREAD samples the timer. Pure arithmetic, so
+// it also builds on a host (tools/host), where a cycle-by-cycle simulation
+// of PREAD and the state machine checks the same counts independently.
+// ---------------------------------------------------------------------------
+#define PADDLE_VALUES       256
+
+// Trigger edge to output low takes count + PADDLE_PIO_CYCLES state machine
+// cycles (2 input synchroniser, wait, pull, 2 x mov, 2 x set, final jmp),
+// plus up to PADDLE_PIO_JITTER more depending on where the edge falls in a
+// cycle
+#define PADDLE_PIO_CYCLES   9
+#define PADDLE_PIO_JITTER   1
+
+// Fill counts[v] with the loop count that makes PREAD return v at clk_sys
+// 'sys_hz'
+void paddle_model_counts(uint32_t sys_hz, uint32_t counts[PADDLE_VALUES]);
+
+uint64_t paddle_model_cycles_to_ps(uint32_t sys_hz, uint64_t cycles);
+
+// Number of values PREAD would read back wrong; the smallest margin
+// between a pulse end and a sample goes to *worst_ps, and its value to
+// *worst_value
+uint32_t paddle_model_check(uint32_t sys_hz, const uint32_t counts[PADDLE_VALUES],
+                            int64_t *worst_ps, uint32_t *worst_value);
+
+#endif
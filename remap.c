@@ -0,0 +1,86 @@
+/*
+ * Key remapping
+ *
+ * Overrides are stored as one config record per remapped key, key
+ * CONFIG_KEY_REMAP_BASE + source keycode, holding the target keycode.
+ * Changes update the live tables straight away; the next report uses them.
+ */
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "config.h"
+#include "remap.h"
+
+#define MODIFIER_KEYCODE_FIRST  0xE0    // LeftCtrl
+#define MODIFIER_KEYCODE_LAST   0xE7    // RightGUI
+
+uint8_t remap_keycode[256];
+uint8_t remap_modifier[256];
+
+static void apply(uint8_t from, uint8_t to) {
+    if (to >= MODIFIER_KEYCODE_FIRST && to <= MODIFIER_KEYCODE_LAST) {
+        remap_keycode[from] = 0;
+        remap_modifier[from] = 1u << (to - MODIFIER_KEYCODE_FIRST);
+    } else {
+        remap_keycode[from] = to;
+        remap_modifier[from] = 0;
+    }
+}
+
+static void apply_record(uint16_t key, const uint8_t *data, uint16_t len) {
+    if (len == 1 && key != CONFIG_KEY_REMAP_BASE) {
+        apply((uint8_t)(key - CONFIG_KEY_REMAP_BASE), data[0]);
+    }
+}
+
+static void reset_tables(void) {
+    for (int i = 0; i < 256; i++) {
+        remap_keycode[i] = (uint8_t)i;
+        remap_modifier[i] = 0;
+    }
+}
+
+void remap_init(void) {
+    reset_tables();
+    config_for_each(CONFIG_KEY_REMAP_BASE, CONFIG_KEY_REMAP_BASE + 0xFF,
+                    apply_record);
+}
+
+void remap_set(uint8_t from, uint8_t to) {
+    // Keycode 0 fills unused report slots and must stay "no key"
+    if (from == 0) {
+        return;
+    }
+    apply(from, to);
+    if (to == from) {
+        config_write(CONFIG_KEY_REMAP_BASE + from, NULL, 0);
+    } else {
+        config_write(CONFIG_KEY_REMAP_BASE + from, &to, 1);
+    }
+}
+
+void remap_clear(void) {
+    for (int i = 0; i < 256; i++) {
+        if (remap_keycode[i] != i || remap_modifier[i] != 0) {
+            remap_set((uint8_t)i, (uint8_t)i);
+        }
+    }
+}
+
+void remap_print(void) {
+    int count = 0;
+    for (int i = 0; i < 256; i++) {
+        if (remap_modifier[i]) {
+            int bit = __builtin_ctz(remap_modifier[i]);
+            printf("  0x%02X -> 0x%02X (modifier)\n", i, MODIFIER_KEYCODE_FIRST + bit);
+            count++;
+        } else if (remap_keycode[i] != i) {
+            printf("  0x%02X -> 0x%02X\n", i, remap_keycode[i]);
+            count++;
+        }
+    }
+    if (count == 0) {
+        printf("  no keys remapped\n");
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef _REMAP_H_
+#define _REMAP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tusb.h"
+
+// ---------------------------------------------------------------------------
+// Key remapping
+//
+// Every report passes through two 256-entry tables before translation:
+// remap_keycode[] gives the keycode to use instead (identity by default,
+// 0 to drop the key) and remap_modifier[] gives modifier bits the key
+// should assert instead. Mapping a key to 0xE0-0xE7 (LeftCtrl..RightGUI)
+// turns it into that modifier, e.g. Caps Lock as Ctrl.
+//
+// The stage is always applied, so with no remap configured it costs the
+// same table loads and no extra branches.
+// ---------------------------------------------------------------------------
+extern uint8_t remap_keycode[256];
+extern uint8_t remap_modifier[256];
+
+// Modifier byte after remapping, for reports whose keys are unchanged
+static inline uint8_t remap_report_modifier(hid_keyboard_report_t const *in) {
+    uint8_t modifier = in->modifier;
+    for (int i = 0; i < 6; i++) {
+        modifier |= remap_modifier[in->keycode[i]];
+    }
+    return modifier;
+}
+
+static inline void remap_report(hid_keyboard_report_t const *in,
+                                hid_keyboard_report_t *out) {
+    uint8_t modifier = in->modifier;
+    for (int i = 0; i < 6; i++) {
+        uint8_t kc = in->keycode[i];
+        modifier |= remap_modifier[kc];
+        out->keycode[i] = remap_keycode[kc];
+    }
+    out->modifier = modifier;
+    out->reserved = in->reserved;
+}
+
+// Reset to identity and apply overrides stored in the config
+void remap_init(void);
+
+// Map 'from' to 'to' (to == from removes the override); saved to config
+void remap_set(uint8_t from, uint8_t to);
+void remap_clear(void);
+void remap_print(void);
+
+#endif
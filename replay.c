@@ -0,0 +1,152 @@
+/*
+ * HID report replay
+ *
+ * Entries are loaded with the "r" console command (one report per line,
+ * normally sent by tools/usbmon_replay.py) and played back by
+ * replay_task(). Speed 1 keeps the captured timing, N runs N times faster
+ * and 0 sends every report on consecutive main loop passes.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "keyboard.h"
+#include "keyq.h"
+#include "replay.h"
+#include "stats.h"
+
+#define REPLAY_MAX_REPORTS   512
+#define REPLAY_MAX_KEYS      512
+#define REPLAY_QUEUE_RESERVE 6      // One report can queue six keys
+
+typedef struct {
+    uint32_t delta_us;
+    hid_keyboard_report_t report;
+} replay_entry_t;
+
+typedef struct {
+    uint32_t time_us;
+    uint8_t ascii;
+} replay_key_t;
+
+static replay_entry_t entries[REPLAY_MAX_REPORTS];
+static uint32_t entry_count = 0;
+
+static replay_key_t keys[REPLAY_MAX_KEYS];
+static uint32_t key_count = 0;
+static uint32_t keys_overflowed = 0;
+
+static bool running = false;
+static bool muted = false;
+static keyboard_profile_t saved_profile = PROFILE_NORMAL;
+static uint32_t speed = 1;
+static uint32_t next_index = 0;
+static uint64_t start_us = 0;
+static uint64_t due_us = 0;
+static stats_counters_t stats_at_start;
+
+bool replay_add(uint32_t delta_us, hid_keyboard_report_t const *report) {
+    if (running || entry_count >= REPLAY_MAX_REPORTS) {
+        return false;
+    }
+    entries[entry_count].delta_us = delta_us;
+    entries[entry_count].report = *report;
+    entry_count++;
+    return true;
+}
+
+void replay_clear(void) {
+    if (!running) {
+        entry_count = 0;
+    }
+}
+
+static void capture(uint8_t ascii) {
+    if (key_count >= REPLAY_MAX_KEYS) {
+        keys_overflowed++;
+        return;
+    }
+    keys[key_count].time_us = (uint32_t)(time_us_64() - start_us);
+    keys[key_count].ascii = ascii;
+    key_count++;
+}
+
+static uint32_t scaled_delay(uint32_t delta_us) {
+    return speed ? delta_us / speed : 0;
+}
+
+void replay_start(uint32_t speed_factor, bool mute) {
+    if (running || entry_count == 0) {
+        return;
+    }
+
+    speed = speed_factor;
+    muted = mute;
+    key_count = 0;
+    keys_overflowed = 0;
+    next_index = 0;
+    stats_at_start = stats_total;
+
+    // The game path ignores muting; keep the live keyboard off it
+    if (muted) {
+        saved_profile = keyboard_get_profile();
+        keyboard_set_profile(PROFILE_NORMAL);
+    }
+    output_set_muted(muted);
+    output_set_tap(capture);
+    start_us = time_us_64();
+    due_us = start_us + scaled_delay(entries[0].delta_us);
+    running = true;
+}
+
+static void finish(void) {
+    uint32_t elapsed = (uint32_t)(time_us_64() - start_us);
+
+    running = false;
+    output_set_tap(NULL);
+    if (muted) {
+        output_set_muted(false);
+        keyboard_set_profile(saved_profile);
+    }
+
+    // Machine-readable: one line per key, then a summary line
+    for (uint32_t i = 0; i < key_count; i++) {
+        printf("out %lu %02X\n", (unsigned long)keys[i].time_us, keys[i].ascii);
+    }
+    printf("done reports=%lu keys=%lu lost_capture=%lu elapsed_us=%lu speed=%lu "
+           "dropped=%lu modifier_only=%lu\n",
+           (unsigned long)next_index, (unsigned long)key_count,
+           (unsigned long)keys_overflowed, (unsigned long)elapsed,
+           (unsigned long)speed,
+           (unsigned long)(stats_total.keys_dropped - stats_at_start.keys_dropped),
+           (unsigned long)(stats_total.modifier_only - stats_at_start.modifier_only));
+}
+
+void replay_stop(void) {
+    if (running) {
+        finish();
+    }
+}
+
+void replay_task(void) {
+    if (!running) {
+        return;
+    }
+
+    // Catch up on every report that is due, so a slow main loop pass does
+    // not stretch the captured timing, but never overrun the output queue
+    uint64_t now = time_us_64();
+    while (next_index < entry_count && now >= due_us &&
+           keyq_space() >= REPLAY_QUEUE_RESERVE) {
+        process_kbd_report(&entries[next_index].report);
+        next_index++;
+        if (next_index < entry_count) {
+            due_us += scaled_delay(entries[next_index].delta_us);
+        }
+    }
+
+    if (next_index >= entry_count && keyq_space() == KEYQ_SIZE) {
+        finish();
+    }
+}
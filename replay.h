@@ -0,0 +1,23 @@
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tusb.h"
+
+// ---------------------------------------------------------------------------
+// HID report replay
+//
+// Captured keyboard reports are uploaded over UART with their inter-report
+// delays, then fed through process_kbd_report() from the main loop at the
+// original or an accelerated speed. Keys produced during the run are
+// captured with timestamps and printed when it finishes.
+// ---------------------------------------------------------------------------
+bool replay_add(uint32_t delta_us, hid_keyboard_report_t const *report);
+void replay_clear(void);
+void replay_start(uint32_t speed, bool mute);
+void replay_stop(void);
+void replay_task(void);
+
+#endif
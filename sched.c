@@ -0,0 +1,151 @@
+/*
+ * Cooperative scheduler
+ *
+ * Per task, since boot or the last "sched clear":
+ *   cpu      share of elapsed time spent in the task
+ *   avg/max  run time per call
+ *   over     runs longer than the task's budget
+ *   late     starts more than the task's deadline after becoming due
+ *
+ * Task timing uses the 32-bit microsecond timer; intervals are computed
+ * with unsigned subtraction and stay correct across its 71 minute wrap.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "looptrace.h"
+#include "sched.h"
+
+typedef struct {
+    uint32_t due_us;
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t late;
+    uint32_t max_us;
+    uint64_t total_us;
+} task_state_t;
+
+static const sched_task_t *table = NULL;
+static task_state_t state[SCHED_TASK_MAX];
+static uint32_t table_count = 0;
+static uint32_t next_background = 0;
+static uint64_t since_us = 0;
+
+void sched_init(const sched_task_t *tasks, uint32_t count) {
+    if (count > SCHED_TASK_MAX) {
+        printf("Warning: only %d of %lu tasks scheduled\n", SCHED_TASK_MAX,
+               (unsigned long)count);
+        count = SCHED_TASK_MAX;
+    }
+    table = tasks;
+    table_count = count;
+    sched_clear();
+}
+
+void sched_clear(void) {
+    uint32_t now = time_us_32();
+    for (uint32_t i = 0; i < table_count; i++) {
+        memset(&state[i], 0, sizeof(state[i]));
+        state[i].due_us = now;
+    }
+    since_us = time_us_64();
+}
+
+static bool is_due(uint32_t i, uint32_t now) {
+    return (int32_t)(now - state[i].due_us) >= 0;
+}
+
+static void run_task(uint32_t i, uint32_t start) {
+    const sched_task_t *task = &table[i];
+    task_state_t *t = &state[i];
+
+    if (start - t->due_us > task->deadline_us) {
+        t->late++;
+    }
+
+    looptrace_site(task->name);
+    task->run();
+
+    uint32_t elapsed = time_us_32() - start;
+    t->runs++;
+    t->total_us += elapsed;
+    if (elapsed > t->max_us) {
+        t->max_us = elapsed;
+    }
+    if (elapsed > task->budget_us) {
+        t->overruns++;
+    }
+
+    // Periodic tasks keep their phase unless they fell a whole period behind
+    if (task->period_us == 0) {
+        t->due_us = start + elapsed;
+    } else {
+        t->due_us += task->period_us;
+        if (is_due(i, start + elapsed)) {
+            t->due_us = start + elapsed;
+        }
+    }
+}
+
+static void run_critical(void) {
+    for (uint32_t i = 0; i < table_count && table[i].priority == SCHED_PRIO_CRITICAL; i++) {
+        uint32_t now = time_us_32();
+        if (is_due(i, now)) {
+            run_task(i, now);
+        }
+    }
+}
+
+void sched_pass(void) {
+    uint32_t first_background = table_count;
+
+    looptrace_pass();
+    run_critical();
+
+    for (uint32_t i = 0; i < table_count; i++) {
+        if (table[i].priority == SCHED_PRIO_CRITICAL) {
+            continue;
+        }
+        if (table[i].priority == SCHED_PRIO_BACKGROUND) {
+            first_background = i;
+            break;
+        }
+        uint32_t now = time_us_32();
+        if (is_due(i, now)) {
+            run_task(i, now);
+            run_critical();
+        }
+    }
+
+    // One background task per pass, starting after the last one that ran
+    uint32_t n = table_count - first_background;
+    for (uint32_t k = 0; k < n; k++) {
+        uint32_t i = first_background + (next_background + k) % n;
+        uint32_t now = time_us_32();
+        if (is_due(i, now)) {
+            run_task(i, now);
+            next_background = (i - first_background + 1) % n;
+            run_critical();
+            break;
+        }
+    }
+}
+
+void sched_print(void) {
+    static const char prio_name[] = "CNB";
+    uint64_t window = time_us_64() - since_us;
+
+    printf("task       p     runs   cpu%%    avg    max budget   over   late\n");
+    for (uint32_t i = 0; i < table_count; i++) {
+        const task_state_t *t = &state[i];
+        uint32_t permille = window ? (uint32_t)(t->total_us * 1000 / window) : 0;
+        printf("%-10s %c %8lu %3lu.%lu %6lu %6lu %6lu %6lu %6lu\n",
+               table[i].name, prio_name[table[i].priority], (unsigned long)t->runs,
+               (unsigned long)(permille / 10), (unsigned long)(permille % 10),
+               (unsigned long)(t->runs ? t->total_us / t->runs : 0),
+               (unsigned long)t->max_us, (unsigned long)table[i].budget_us,
+               (unsigned long)t->overruns, (unsigned long)t->late);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------
+// Cooperative scheduler
+//
+// The main loop is a table of tasks run by sched_pass(). Tasks are plain
+// functions that do a bounded amount of work and return; nothing is
+// preempted. Priorities decide what runs in a pass:
+//
+//   CRITICAL    run first and again after every lower-priority task, so
+//               the gap between two runs is bounded by the longest single
+//               task rather than by the whole pass (USB host servicing)
+//   NORMAL      run once per pass, when due
+//   BACKGROUND  at most one per pass, round robin, when due
+//
+// A task is due when 'period_us' has elapsed since it last started (0 =
+// every pass). Running longer than 'budget_us' counts an overrun; starting
+// more than 'deadline_us' after becoming due counts a late start.
+// ---------------------------------------------------------------------------
+typedef enum {
+    SCHED_PRIO_CRITICAL,
+    SCHED_PRIO_NORMAL,
+    SCHED_PRIO_BACKGROUND,
+} sched_prio_t;
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+    sched_prio_t priority;
+    uint32_t period_us;
+    uint32_t budget_us;
+    uint32_t deadline_us;
+} sched_task_t;
+
+#define SCHED_TASK_MAX  16
+
+// Use 'tasks' (kept by reference) for all following passes. The table
+// must be listed in priority order.
+void sched_init(const sched_task_t *tasks, uint32_t count);
+
+void sched_pass(void);
+
+void sched_print(void);
+void sched_clear(void);
+
+#endif
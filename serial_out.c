@@ -0,0 +1,76 @@
+/*
+ * Serial ASCII output on UART1
+ *
+ * The ring is written from output_key() (main loop or, in game mode, the
+ * report callback, which tuh_task() also runs from the main loop) and read
+ * by serial_out_task(), so producer and consumer never run concurrently.
+ */
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/uart.h"
+#include "config.h"
+#include "serial_out.h"
+
+#define SERIAL_UART     uart1
+#define RING_MASK       (SERIAL_OUT_RING - 1)
+
+static uint8_t ring[SERIAL_OUT_RING];
+static uint32_t head;           // Next slot to write
+static uint32_t tail;           // Next slot to send
+
+static uint32_t baud;           // Setting the UART was last programmed with
+static uint32_t sent;
+static uint32_t dropped;
+static uint32_t ring_max;
+
+void serial_out_init(void) {
+    baud = config.serial_baud;
+    uart_init(SERIAL_UART, baud);
+    gpio_set_function(SERIAL_OUT_TX_PIN, GPIO_FUNC_UART);
+}
+
+void serial_out_put(uint8_t ascii) {
+    // 7-bit like the bus: KEY_CODE_NUL (Ctrl-@) goes out as NUL
+    ascii &= 0x7F;
+    if (head == tail && uart_is_writable(SERIAL_UART)) {
+        uart_putc_raw(SERIAL_UART, (char)ascii);
+        sent++;
+        return;
+    }
+
+    uint32_t depth = head - tail;
+    if (depth >= SERIAL_OUT_RING) {
+        dropped++;
+        return;
+    }
+    ring[head & RING_MASK] = ascii;
+    head++;
+    if (depth + 1 > ring_max) {
+        ring_max = depth + 1;
+    }
+}
+
+void serial_out_task(void) {
+    while (head != tail && uart_is_writable(SERIAL_UART)) {
+        uart_putc_raw(SERIAL_UART, (char)ring[tail & RING_MASK]);
+        tail++;
+        sent++;
+    }
+
+    // Apply a new baud rate once the backlog has gone to the FIFO
+    if (head == tail && config.serial_baud != baud) {
+        baud = config.serial_baud;
+        uart_set_baudrate(SERIAL_UART, baud);
+    }
+}
+
+void serial_out_print(void) {
+    printf("UART1 TX GP%d, %lu baud 8N1, output %s\n", SERIAL_OUT_TX_PIN,
+           (unsigned long)baud, (config.outputs & OUTPUT_SERIAL) ? "on" : "off");
+    printf("sent %lu, backlog %lu (max %lu of %d), dropped %lu\n",
+           (unsigned long)sent, (unsigned long)(head - tail),
+           (unsigned long)ring_max, SERIAL_OUT_RING, (unsigned long)dropped);
+}
@@ -0,0 +1,27 @@
+#ifndef _SERIAL_OUT_H_
+#define _SERIAL_OUT_H_
+
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Serial ASCII output
+//
+// Output backend for machines that take serial ASCII instead of a parallel
+// strobe (Apple-1 replicas, terminals): each key is sent as one 8N1
+// character on UART1 TX (GP20) at the serial_baud setting. Selected with
+// the outputs setting, alongside or instead of the parallel bus.
+//
+// serial_out_put() never waits on the line. A key goes straight into the
+// UART's 32-byte FIFO when there is room and nothing is backlogged,
+// otherwise into a software ring that serial_out_task() drains; a key
+// arriving with the ring full is dropped and counted.
+// ---------------------------------------------------------------------------
+#define SERIAL_OUT_TX_PIN   20
+#define SERIAL_OUT_RING     64      // Power of two
+
+void serial_out_init(void);
+void serial_out_put(uint8_t ascii);
+void serial_out_task(void);
+void serial_out_print(void);
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * Stack high-water marks
+ *
+ * Stack regions come from the SDK linker script: core 0 runs on the
+ * PICO_STACK_SIZE area at the top of SCRATCH_Y, core 1 (unused by this
+ * firmware) on the PICO_CORE1_STACK_SIZE area at the top of SCRATCH_X.
+ * Core 0's stack is live when painting starts, so only the part below the
+ * current stack pointer, less a margin for stackmon_init() itself, is
+ * painted; anything above it counts as used from the start.
+ */
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "stackmon.h"
+
+#define STACK_PAINT         0x5AC75AC7u
+#define PAINT_MARGIN_WORDS  16
+
+extern uint32_t __StackBottom;
+extern uint32_t __StackTop;
+extern uint32_t __StackOneBottom;
+extern uint32_t __StackOneTop;
+
+static void stack_bounds(int core, uint32_t **bottom, uint32_t **top) {
+    if (core == 0) {
+        *bottom = &__StackBottom;
+        *top = &__StackTop;
+    } else {
+        *bottom = &__StackOneBottom;
+        *top = &__StackOneTop;
+    }
+}
+
+void __attribute__((noinline)) stackmon_init(void) {
+    uint32_t marker;
+    uint32_t *bottom, *top;
+
+    stack_bounds(0, &bottom, &top);
+    uint32_t *limit = &marker - PAINT_MARGIN_WORDS;
+    for (volatile uint32_t *p = bottom; p < limit; p++) {
+        *p = STACK_PAINT;
+    }
+
+    stack_bounds(1, &bottom, &top);
+    for (volatile uint32_t *p = bottom; p < top; p++) {
+        *p = STACK_PAINT;
+    }
+}
+
+uint32_t stackmon_used(int core, uint32_t *size) {
+    uint32_t *bottom, *top;
+    stack_bounds(core, &bottom, &top);
+
+    const volatile uint32_t *p = bottom;
+    while (p < top && *p == STACK_PAINT) {
+        p++;
+    }
+    if (size) {
+        *size = (uint32_t)((top - bottom) * sizeof(uint32_t));
+    }
+    return (uint32_t)((top - p) * sizeof(uint32_t));
+}
+
+void stackmon_print(void) {
+    for (int core = 0; core < 2; core++) {
+        uint32_t size;
+        uint32_t used = stackmon_used(core, &size);
+        printf("core %d stack: %lu of %lu bytes used (%lu%%), %lu free%s\n", core,
+               (unsigned long)used, (unsigned long)size,
+               (unsigned long)(size ? used * 100 / size : 0),
+               (unsigned long)(size - used), core == 1 && used == 0 ? " (core idle)" : "");
+    }
+}
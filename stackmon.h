@@ -0,0 +1,22 @@
+#ifndef _STACKMON_H_
+#define _STACKMON_H_
+
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Stack high-water marks
+//
+// stackmon_init() fills the unused part of each core's stack with a known
+// word. The deepest point either stack has reached is then found by
+// scanning up from the bottom for the first overwritten word.
+// ---------------------------------------------------------------------------
+
+// Call first thing in main(), before anything deep has run
+void stackmon_init(void);
+
+// Bytes of the core's stack used so far, and its size
+uint32_t stackmon_used(int core, uint32_t *size);
+
+void stackmon_print(void);
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Statistics counters
+ *
+ * stats_total accumulates since boot. Once per second stats_task() takes
+ * the difference against the previous sample, giving the per-second rates
+ * printed by the "stats" console command.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "stats.h"
+
+#define STATS_WINDOW_MS   1000
+
+stats_counters_t stats_total = {0};
+
+static stats_counters_t last_sample = {0};
+static stats_counters_t last_window = {0};
+static uint32_t window_start_ms = 0;
+
+void stats_task(void) {
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    if (now - window_start_ms < STATS_WINDOW_MS) {
+        return;
+    }
+    window_start_ms = now;
+
+    stats_counters_t snap = stats_total;
+    last_window.reports       = snap.reports       - last_sample.reports;
+    last_window.pad_reports   = snap.pad_reports   - last_sample.pad_reports;
+    last_window.keys_emitted  = snap.keys_emitted  - last_sample.keys_emitted;
+    last_window.keys_dropped  = snap.keys_dropped  - last_sample.keys_dropped;
+    last_window.modifier_only = snap.modifier_only - last_sample.modifier_only;
+    last_window.fast_path     = snap.fast_path     - last_sample.fast_path;
+    last_window.resets        = snap.resets        - last_sample.resets;
+    last_window.bus_busy_us   = snap.bus_busy_us   - last_sample.bus_busy_us;
+
+    // Queue depth is a high-water mark, not a count: report the peak seen
+    // during the window and start the next window from zero.
+    last_window.queue_depth_max = snap.queue_depth_max;
+    stats_total.queue_depth_max = 0;
+
+    last_sample = snap;
+}
+
+void stats_print(void) {
+    printf("             last 1s      total\n");
+    printf("reports    %10lu %10lu\n",
+           (unsigned long)last_window.reports, (unsigned long)stats_total.reports);
+    printf("pad/mouse  %10lu %10lu\n",
+           (unsigned long)last_window.pad_reports, (unsigned long)stats_total.pad_reports);
+    printf("keys       %10lu %10lu\n",
+           (unsigned long)last_window.keys_emitted, (unsigned long)stats_total.keys_emitted);
+    printf("dropped    %10lu %10lu\n",
+           (unsigned long)last_window.keys_dropped, (unsigned long)stats_total.keys_dropped);
+    printf("mod-only   %10lu %10lu\n",
+           (unsigned long)last_window.modifier_only, (unsigned long)stats_total.modifier_only);
+    printf("fast path  %10lu %10lu (%lu%% of reports)\n",
+           (unsigned long)last_window.fast_path, (unsigned long)stats_total.fast_path,
+           (unsigned long)(stats_total.reports ?
+               (uint64_t)stats_total.fast_path * 100 / stats_total.reports : 0));
+    printf("resets     %10lu %10lu\n",
+           (unsigned long)last_window.resets, (unsigned long)stats_total.resets);
+    printf("queue max  %10lu\n", (unsigned long)last_window.queue_depth_max);
+    printf("bus busy   %10lu us (%lu.%lu%%)\n",
+           (unsigned long)last_window.bus_busy_us,
+           (unsigned long)(last_window.bus_busy_us / 10000),
+           (unsigned long)(last_window.bus_busy_us / 1000 % 10));
+}
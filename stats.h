@@ -0,0 +1,46 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Event counters
+//
+// Incremented from the hot path with a single add each. stats_task() folds
+// the running totals into a rolling one-second window once per second, so
+// the rates reported over UART are per-second deltas, not averages since
+// boot.
+// ---------------------------------------------------------------------------
+typedef struct {
+    uint32_t reports;           // Keyboard reports received
+    uint32_t pad_reports;       // Gamepad and mouse reports received
+    uint32_t keys_emitted;      // Characters strobed onto the bus
+    uint32_t keys_dropped;      // Keys lost to rollover/queue overflow
+    uint32_t modifier_only;     // Reports where only the modifier byte changed
+    uint32_t fast_path;         // Reports handled without the key scan
+    uint32_t resets;            // RESET pulses issued
+    uint32_t bus_busy_us;       // Time spent driving data + STROBE
+    uint32_t queue_depth_max;   // Deepest output queue seen
+} stats_counters_t;
+
+extern stats_counters_t stats_total;
+
+static inline void stats_report(void)          { stats_total.reports++; }
+static inline void stats_pad_report(void)      { stats_total.pad_reports++; }
+static inline void stats_key_emitted(void)     { stats_total.keys_emitted++; }
+static inline void stats_key_dropped(void)     { stats_total.keys_dropped++; }
+static inline void stats_modifier_only(void)   { stats_total.modifier_only++; }
+static inline void stats_fast_path(void)       { stats_total.fast_path++; }
+static inline void stats_reset(void)           { stats_total.resets++; }
+static inline void stats_bus_busy(uint32_t us) { stats_total.bus_busy_us += us; }
+
+static inline void stats_queue_depth(uint32_t depth) {
+    if (depth > stats_total.queue_depth_max) {
+        stats_total.queue_depth_max = depth;
+    }
+}
+
+void stats_task(void);
+void stats_print(void);
+
+#endif
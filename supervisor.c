@@ -0,0 +1,239 @@
+/*
+ * Watchdog and USB host supervision
+ *
+ * Downtime of a USB recovery runs from the last sign of life (SOF
+ * progress, the start of the stuck LED transfer, or the last report or
+ * probe completion) to the next keyboard mount, i.e. until keys can be
+ * typed again.
+ *
+ * SOF is generated by the controller, so it keeps counting when the
+ * TinyUSB stack itself is wedged. The liveness probe covers that: a
+ * keyboard that has been quiet for SUPERVISOR_PROBE_IDLE_MS is sent a
+ * GET_DESCRIPTOR(device), which only completes if the stack is still
+ * scheduling and finishing transfers.
+ *
+ * Watchdog scratch registers 0-3 survive a watchdog reboot (the SDK uses
+ * 4-7) and carry the reboot count and the reason for an intentional one.
+ */
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/watchdog.h"
+#include "hardware/structs/usb.h"
+#include "tusb.h"
+#include "devices.h"
+#include "gamepad.h"
+#include "keyboard.h"
+#include "supervisor.h"
+
+#define SCRATCH_MAGIC       0x53425744      // "SBWD"
+#define SCRATCH_MAGIC_REG   0
+#define SCRATCH_COUNT_REG   1
+#define SCRATCH_REASON_REG  2
+
+#define USB_RHPORT          0
+
+static struct {
+    uint32_t watchdog_reboots;      // Since power-on
+    uint32_t stalls;
+    uint32_t reinit_failures;
+    uint32_t last_downtime_ms;
+    uint32_t max_downtime_ms;
+    const char *last_cause;
+} counts;
+
+static uint16_t last_sof = 0;
+static uint32_t last_progress_ms = 0;
+
+static struct {
+    bool busy;
+    uint8_t dev_addr;
+    uint32_t sent_ms;
+    uint32_t last_alive_ms;     // Last probe completion
+    uint32_t sent;
+    uint32_t failed;            // Completed with an error (stack still alive)
+    uint8_t buf[18];            // Device descriptor
+} probe;
+
+static bool recovering = false;
+static uint32_t stall_start_ms = 0;
+
+static uint32_t now_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+void supervisor_init(void) {
+    if (watchdog_hw->scratch[SCRATCH_MAGIC_REG] != SCRATCH_MAGIC) {
+        watchdog_hw->scratch[SCRATCH_MAGIC_REG] = SCRATCH_MAGIC;
+        watchdog_hw->scratch[SCRATCH_COUNT_REG] = 0;
+        watchdog_hw->scratch[SCRATCH_REASON_REG] = SUPERVISOR_REASON_HANG;
+    }
+
+    if (watchdog_caused_reboot()) {
+        static const char *const reasons[] = {
+            "main loop hung", "USB host restart failed", "crash",
+        };
+        uint32_t reason = watchdog_hw->scratch[SCRATCH_REASON_REG];
+        counts.watchdog_reboots = ++watchdog_hw->scratch[SCRATCH_COUNT_REG];
+        printf("Restarted by watchdog (%s), %lu since power-on\n",
+               reason < 3 ? reasons[reason] : "unknown",
+               (unsigned long)counts.watchdog_reboots);
+        watchdog_hw->scratch[SCRATCH_REASON_REG] = SUPERVISOR_REASON_HANG;
+    }
+
+    watchdog_enable(SUPERVISOR_WATCHDOG_MS, true);
+}
+
+void supervisor_reboot(uint32_t reason) {
+    watchdog_hw->scratch[SCRATCH_REASON_REG] = reason;
+    watchdog_reboot(0, 0, 0);
+    while (true) {
+        tight_loop_contents();
+    }
+}
+
+static void usb_restart(const char *cause, uint32_t since_ms) {
+    counts.stalls++;
+    counts.last_cause = cause;
+    if (!recovering) {
+        recovering = true;
+        stall_start_ms = since_ms;
+    }
+    printf("USB host stalled (%s), restarting\n", cause);
+
+    // Forget the devices first; umount callbacks from the teardown then
+    // find nothing to do
+    keyboard_detach_all();
+    gamepad_detach_all();
+
+    if (!tuh_deinit(USB_RHPORT) || !tuh_init(USB_RHPORT)) {
+        counts.reinit_failures++;
+        printf("USB host restart failed, rebooting\n");
+        supervisor_reboot(SUPERVISOR_REASON_USB_REINIT);
+    }
+    probe.busy = false;
+    last_progress_ms = now_ms();
+    probe.last_alive_ms = last_progress_ms;
+}
+
+static void probe_complete(tuh_xfer_t *xfer) {
+    probe.busy = false;
+    probe.last_alive_ms = now_ms();
+    if (xfer->result != XFER_RESULT_SUCCESS) {
+        probe.failed++;
+    }
+}
+
+// Most recent sign that reports or transfers are completing
+static uint32_t last_alive(uint32_t now) {
+    uint64_t newest_us = 0;
+    for (int i = 0; i < KBD_DEVICE_MAX; i++) {
+        const kbd_device_t *d = &kbd_devices[i];
+        if (d->mounted && d->last_report_us > newest_us) {
+            newest_us = d->last_report_us;
+        }
+    }
+    uint32_t report_ms = (uint32_t)(newest_us / 1000);
+    uint32_t alive = probe.last_alive_ms;
+    if (newest_us && (int32_t)(report_ms - alive) > 0) {
+        alive = report_ms;
+    }
+    return (int32_t)(alive - now) > 0 ? now : alive;
+}
+
+static void probe_task(uint32_t now) {
+    if (probe.busy) {
+        const kbd_device_t *target = NULL;
+        for (int i = 0; i < KBD_DEVICE_MAX; i++) {
+            if (kbd_devices[i].mounted && kbd_devices[i].dev_addr == probe.dev_addr) {
+                target = &kbd_devices[i];
+            }
+        }
+        if (!target) {
+            // Unplugged with the probe in flight
+            probe.busy = false;
+            probe.last_alive_ms = now;
+        } else if (now - probe.sent_ms > SUPERVISOR_PROBE_STALL_MS) {
+            usb_restart("liveness probe timed out", last_alive(probe.sent_ms));
+        }
+        return;
+    }
+
+    if (now - last_alive(now) < SUPERVISOR_PROBE_IDLE_MS) {
+        return;
+    }
+    for (int i = 0; i < KBD_DEVICE_MAX; i++) {
+        const kbd_device_t *d = &kbd_devices[i];
+        if (!d->mounted) {
+            continue;
+        }
+        // Refused while another control transfer is using the pipe;
+        // tried again on the next pass
+        if (tuh_descriptor_get_device(d->dev_addr, probe.buf, sizeof(probe.buf),
+                                      probe_complete, 0)) {
+            probe.busy = true;
+            probe.dev_addr = d->dev_addr;
+            probe.sent_ms = now;
+            probe.sent++;
+        }
+        return;
+    }
+}
+
+void supervisor_task(void) {
+    watchdog_update();
+
+    uint32_t now = now_ms();
+    if (!kbd_device_any_mounted()) {
+        last_progress_ms = now;
+        probe.busy = false;
+        probe.last_alive_ms = now;
+        return;
+    }
+
+    uint16_t sof = usb_hw->sof_rd & USB_SOF_RD_BITS;
+    if (sof != last_sof) {
+        last_sof = sof;
+        last_progress_ms = now;
+    } else if (now - last_progress_ms > SUPERVISOR_SOF_STALL_MS) {
+        usb_restart("SOF stopped", last_progress_ms);
+        return;
+    }
+
+    for (int i = 0; i < KBD_DEVICE_MAX; i++) {
+        const kbd_device_t *d = &kbd_devices[i];
+        if (d->mounted && d->led_busy && now - d->led_sent_ms > SUPERVISOR_LED_STALL_MS) {
+            usb_restart("LED report timed out", d->led_sent_ms);
+            return;
+        }
+    }
+
+    probe_task(now);
+}
+
+void supervisor_keyboard_mounted(void) {
+    if (!recovering) {
+        return;
+    }
+    recovering = false;
+    counts.last_downtime_ms = now_ms() - stall_start_ms;
+    if (counts.last_downtime_ms > counts.max_downtime_ms) {
+        counts.max_downtime_ms = counts.last_downtime_ms;
+    }
+    printf("USB recovered, keyboard back after %lu ms\n",
+           (unsigned long)counts.last_downtime_ms);
+}
+
+void supervisor_print(void) {
+    printf("watchdog      %lu ms timeout, %lu reboots since power-on\n",
+           (unsigned long)SUPERVISOR_WATCHDOG_MS, (unsigned long)counts.watchdog_reboots);
+    printf("usb stalls    %lu (last: %s)\n", (unsigned long)counts.stalls,
+           counts.last_cause ? counts.last_cause : "none");
+    printf("restart fail  %lu\n", (unsigned long)counts.reinit_failures);
+    printf("probes        %lu sent, %lu failed%s\n", (unsigned long)probe.sent,
+           (unsigned long)probe.failed, probe.busy ? " (in flight)" : "");
+    printf("downtime      last %lu ms, max %lu ms%s\n",
+           (unsigned long)counts.last_downtime_ms, (unsigned long)counts.max_downtime_ms,
+           recovering ? " (recovering)" : "");
+}
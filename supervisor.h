@@ -0,0 +1,43 @@
+#ifndef _SUPERVISOR_H_
+#define _SUPERVISOR_H_
+
+#include <stdint.h>
+
+// ---------------------------------------------------------------------------
+// Watchdog and USB host supervision
+//
+// The hardware watchdog is fed from supervisor_task(), so it only fires if
+// the main loop itself stops. A wedged USB host is caught separately while
+// a keyboard is mounted: the SOF frame counter must keep advancing, an
+// LED SET_REPORT must complete within SUPERVISOR_LED_STALL_MS, and a
+// keyboard with no reports for SUPERVISOR_PROBE_IDLE_MS is probed with a
+// GET_DESCRIPTOR that must complete within SUPERVISOR_PROBE_STALL_MS. A stall
+// restarts just the USB host stack; only if that fails is the board
+// rebooted through the watchdog.
+// ---------------------------------------------------------------------------
+#define SUPERVISOR_WATCHDOG_MS    3000    // Above the longest RESET pulse (2 s)
+#define SUPERVISOR_SOF_STALL_MS   50      // SOF is sent every 1 ms
+#define SUPERVISOR_LED_STALL_MS   500
+#define SUPERVISOR_PROBE_IDLE_MS  1000
+#define SUPERVISOR_PROBE_STALL_MS 500
+
+// Reasons recorded for a watchdog reboot
+#define SUPERVISOR_REASON_HANG        0   // Watchdog was not fed
+#define SUPERVISOR_REASON_USB_REINIT  1   // USB host restart failed
+#define SUPERVISOR_REASON_CRASH       2   // HardFault or panic (crashlog.c)
+
+// Call before tusb_init()
+void supervisor_init(void);
+
+void supervisor_task(void);
+
+// A keyboard finished mounting; closes an open recovery
+void supervisor_keyboard_mounted(void);
+
+void supervisor_print(void);
+
+// Reboot through the watchdog, recording 'reason'. Only touches hardware
+// registers, so it can be used from fault handlers.
+void supervisor_reboot(uint32_t reason) __attribute__((noreturn));
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Native benchmarks for the SDK-free parts of the keystroke path
+ *
+ * The same cases as the device `bench` command where they build on a
+ * host, timed with the monotonic clock. One line per case:
+ *
+ *   bench_host,<case>,<iterations>,<avg_ns>
+ *
+ * Host figures only show relative changes between commits; the device
+ * `bench` command gives the cycle counts that matter on the RP2040.
+ * process_kbd_report, is_new_key and the output stage live in main.c,
+ * which needs the SDK, and are benchmarked on the device only.
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "abbrev.h"
+#include "compose.h"
+#include "config.h"
+#include "host_test.h"
+#include "keyboard.h"
+
+#define BENCH_ITERATIONS   1000000
+#define BENCH_ABBREV_NODES 4096
+
+config_t config;
+static volatile uint8_t sink;
+
+bool keyq_push(uint8_t ascii, uint32_t delay_us) {
+    sink = ascii;
+    return true;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void report(const char *name, uint64_t start) {
+    uint64_t elapsed = now_ns() - start;
+    printf("bench_host,%s,%d,%.1f\n", name, BENCH_ITERATIONS,
+           (double)elapsed / BENCH_ITERATIONS);
+}
+
+// Same synthetic dictionary as the device benchmark
+static void synthetic_trigger(uint32_t index, char *buf, size_t len) {
+    uint32_t x = index * 2654435761u + 1;
+    size_t n = 3 + (x >> 28) % 4;
+    if (n > len - 1) {
+        n = len - 1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        buf[i] = 'A' + x % 26;
+    }
+    buf[n] = '\0';
+}
+
+int main(void) {
+    keyboard_set_layout(LAYOUT_US);
+    compose_init();
+
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        sink = hid_to_ascii(HID_KEY_A + i % 26, KEYBOARD_MODIFIER_LEFTSHIFT);
+    }
+    report("hid_to_ascii", start);
+
+    start = now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        compose_start();
+        sink = compose_feed('E');
+        sink = compose_feed('S');
+        sink = compose_feed('C');
+    }
+    report("compose_esc", start);
+
+    static const uint32_t sizes[] = { 10, 100, 1000 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        char name[24];
+        snprintf(name, sizeof(name), "abbrev_step_%lu", (unsigned long)sizes[s]);
+        if (!abbrev_build(sizes[s], BENCH_ABBREV_NODES, synthetic_trigger)) {
+            printf("bench_host,%s,0,0\n", name);
+            host_test_failed++;
+            continue;
+        }
+        uint32_t rng = 12345;
+        start = now_ns();
+        for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            sink = (uint8_t)abbrev_step('A' + rng % 26);
+        }
+        report(name, start);
+    }
+    abbrev_init();
+
+    return host_test_failed;
+}
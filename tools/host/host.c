@@ -0,0 +1,11 @@
+/*
+ * Shared state for the host tests: the simulated clock and the check
+ * counter. Everything else a module needs from the firmware is stubbed in
+ * the test that builds it, so each test states its own boundary.
+ */
+
+#include "pico/stdlib.h"
+#include "host_test.h"
+
+uint64_t host_time_us = 0;
+int host_test_failed = 0;
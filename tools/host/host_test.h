@@ -0,0 +1,33 @@
+#ifndef _HOST_TEST_H_
+#define _HOST_TEST_H_
+
+#include <stdio.h>
+
+// ---------------------------------------------------------------------------
+// Minimal checks for the host tests: a failed CHECK prints where and
+// carries on, and main() returns host_test_failures() so ctest sees it.
+// ---------------------------------------------------------------------------
+extern int host_test_failed;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            host_test_failed++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(got, want) do { \
+        long long g_ = (long long)(got), w_ = (long long)(want); \
+        if (g_ != w_) { \
+            printf("%s:%d: %s = %lld, expected %lld\n", __FILE__, __LINE__, \
+                   #got, g_, w_); \
+            host_test_failed++; \
+        } \
+    } while (0)
+
+static inline int host_test_failures(const char *name) {
+    printf("%s: %s\n", name, host_test_failed ? "FAIL" : "PASS");
+    return host_test_failed ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef _HOST_PICO_STDLIB_H_
+#define _HOST_PICO_STDLIB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// ---------------------------------------------------------------------------
+// Host stand-in for the parts of pico/stdlib.h the SDK-free modules use
+//
+// Time is a counter the tests set and advance (host_time_us), so every run
+// sees the same timestamps.
+// ---------------------------------------------------------------------------
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+extern uint64_t host_time_us;
+
+static inline uint64_t time_us_64(void) {
+    return host_time_us;
+}
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)host_time_us;
+}
+
+static inline absolute_time_t get_absolute_time(void) {
+    return host_time_us;
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef _HOST_TUSB_H_
+#define _HOST_TUSB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------------------
+// Host stand-in for the TinyUSB HID definitions the SDK-free modules use.
+// Values are those of TinyUSB's class/hid/hid.h.
+// ---------------------------------------------------------------------------
+typedef struct {
+    uint8_t modifier;
+    uint8_t reserved;
+    uint8_t keycode[6];
+} hid_keyboard_report_t;
+
+#define KEYBOARD_MODIFIER_LEFTCTRL    0x01
+#define KEYBOARD_MODIFIER_LEFTSHIFT   0x02
+#define KEYBOARD_MODIFIER_LEFTALT     0x04
+#define KEYBOARD_MODIFIER_LEFTGUI     0x08
+#define KEYBOARD_MODIFIER_RIGHTCTRL   0x10
+#define KEYBOARD_MODIFIER_RIGHTSHIFT  0x20
+#define KEYBOARD_MODIFIER_RIGHTALT    0x40
+#define KEYBOARD_MODIFIER_RIGHTGUI    0x80
+
+#define HID_KEY_A             0x04
+#define HID_KEY_Z             0x1D
+#define HID_KEY_1             0x1E
+#define HID_KEY_2             0x1F
+#define HID_KEY_0             0x27
+#define HID_KEY_ENTER         0x28
+#define HID_KEY_MINUS         0x2D
+#define HID_KEY_EUROPE_1      0x32
+#define HID_KEY_SEMICOLON     0x33
+#define HID_KEY_APOSTROPHE    0x34
+#define HID_KEY_SLASH         0x38
+#define HID_KEY_ARROW_LEFT    0x50
+#define HID_KEY_EUROPE_2      0x64
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Abbreviation expansion: the Aho-Corasick automaton and what
+ * abbrev_filter() queues
+ */
+
+#include <string.h>
+
+#include "abbrev.h"
+#include "config.h"
+#include "host_test.h"
+
+config_t config;
+
+static uint8_t queued[64];
+static size_t queued_len;
+
+bool keyq_push(uint8_t ascii, uint32_t delay_us) {
+    if (queued_len < sizeof(queued)) {
+        queued[queued_len++] = ascii;
+    }
+    return true;
+}
+
+// Type 'keys'; returns how many of them completed a trigger
+static int type(const char *keys) {
+    int expanded = 0;
+    queued_len = 0;
+    for (const char *p = keys; *p; p++) {
+        expanded += abbrev_filter((uint8_t)*p);
+    }
+    return expanded;
+}
+
+static void synthetic_trigger(uint32_t index, char *buf, size_t len) {
+    uint32_t x = index * 2654435761u + 1;
+    size_t n = 3 + (x >> 28) % 4;
+    for (size_t i = 0; i < n && i < len - 1; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        buf[i] = 'A' + x % 26;
+    }
+    buf[n < len - 1 ? n : len - 1] = '\0';
+}
+
+int main(void) {
+    abbrev_init();
+
+    // The completing key is swallowed; the rest is erased and replaced
+    CHECK_EQ(type("\\CL"), 1);
+    CHECK_EQ(queued_len, 2 + strlen("CALL -151\r"));
+    CHECK(memcmp(queued, "\x08\x08" "CALL -151\r", queued_len) == 0);
+
+    CHECK_EQ(type("\\cl"), 1);
+    CHECK_EQ(type("X\\CAT"), 1);
+    CHECK_EQ(type("\\IN6\\P6"), 2);
+
+    // Control characters mean the cursor moved: no match across them
+    CHECK_EQ(type("\\C\rL"), 0);
+    CHECK_EQ(type("CL"), 0);
+
+    // Large automatons take a heap pool; the built-in one fits in 256 nodes
+    CHECK(abbrev_build(1000, 4096, synthetic_trigger));
+    CHECK(!abbrev_build(1000, 256, synthetic_trigger));
+    CHECK(!abbrev_build(10, 70000, synthetic_trigger));
+    CHECK_EQ(type("\\CL"), 0);
+    abbrev_init();
+    CHECK_EQ(type("\\CL"), 1);
+
+    return host_test_failures("abbrev");
+}
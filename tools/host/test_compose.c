@@ -0,0 +1,51 @@
+/*
+ * Compose sequences: the transition table built by compose_init()
+ */
+
+#include "compose.h"
+#include "host_test.h"
+
+// Feed 'keys' after Menu; returns what the last key produced
+static uint8_t compose(const char *keys) {
+    uint8_t out = 0;
+    compose_start();
+    for (const char *p = keys; *p; p++) {
+        CHECK_EQ(out, 0);
+        out = compose_feed((uint8_t)*p);
+    }
+    return out;
+}
+
+int main(void) {
+    compose_init();
+
+    CHECK_EQ(compose("@"), KEY_CODE_NUL);
+    CHECK_EQ(compose("["), 0x1B);
+    CHECK_EQ(compose("ESC"), 0x1B);
+    CHECK_EQ(compose("esc"), 0x1B);
+    CHECK_EQ(compose("NUL"), KEY_CODE_NUL);
+    CHECK_EQ(compose("BS"), 0x08);
+    CHECK_EQ(compose("BEL"), 0x07);
+    CHECK_EQ(compose("DEL"), 0x7F);
+    CHECK_EQ(compose_state, 0);
+
+    // A key with no transition abandons the sequence and is swallowed
+    CHECK_EQ(compose("EX"), 0);
+    CHECK_EQ(compose_state, 0);
+
+    // A prefix leaves the sequence open until reset
+    compose_start();
+    CHECK_EQ(compose_feed('E'), 0);
+    CHECK(compose_state != 0);
+    compose_reset();
+    CHECK_EQ(compose_state, 0);
+
+    // Ctrl table: letters of both cases and @ [ \ ] ^ _
+    CHECK_EQ(ctrl_code['a'], 0x01);
+    CHECK_EQ(ctrl_code['Z'], 0x1A);
+    CHECK_EQ(ctrl_code['@'], KEY_CODE_NUL);
+    CHECK_EQ(ctrl_code['_'], 0x1F);
+    CHECK_EQ(ctrl_code['1'], 0);
+
+    return host_test_failures("compose");
+}
@@ -0,0 +1,90 @@
+/*
+ * Keycode translation: layouts, Caps Lock and Ctrl through hid_to_ascii()
+ */
+
+#include "compose.h"
+#include "host_test.h"
+#include "keyboard.h"
+#include "layouts.h"
+
+#define SHIFT   KEYBOARD_MODIFIER_LEFTSHIFT
+#define CTRL    KEYBOARD_MODIFIER_LEFTCTRL
+#define RSHIFT  KEYBOARD_MODIFIER_RIGHTSHIFT
+#define RCTRL   KEYBOARD_MODIFIER_RIGHTCTRL
+
+static void test_us(void) {
+    keyboard_set_layout(LAYOUT_US);
+    keyboard_set_caps_lock(false);
+    CHECK_EQ(hid_to_ascii(HID_KEY_A, 0), 'a');
+    CHECK_EQ(hid_to_ascii(HID_KEY_A, SHIFT), 'A');
+    CHECK_EQ(hid_to_ascii(HID_KEY_A, RSHIFT), 'A');
+    CHECK_EQ(hid_to_ascii(HID_KEY_1, SHIFT), '!');
+    CHECK_EQ(hid_to_ascii(HID_KEY_ENTER, 0), '\r');
+    CHECK_EQ(hid_to_ascii(HID_KEY_ARROW_LEFT, 0), 0x08);
+    CHECK_EQ(hid_to_ascii(0xFF, 0), 0);
+    CHECK_EQ(hid_to_ascii(KEYCODE_TABLE_SIZE, 0), 0);
+}
+
+static void test_caps_lock(void) {
+    keyboard_set_layout(LAYOUT_US);
+    keyboard_set_caps_lock(true);
+    CHECK_EQ(hid_to_ascii(HID_KEY_A, 0), 'A');
+    CHECK_EQ(hid_to_ascii(HID_KEY_A, SHIFT), 'a');
+    // Letters only
+    CHECK_EQ(hid_to_ascii(HID_KEY_1, 0), '1');
+    CHECK_EQ(hid_to_ascii(HID_KEY_1, SHIFT), '!');
+
+    // Letters are found by what the layout produces: on AZERTY the Q
+    // keycode types 'a'
+    keyboard_set_layout(LAYOUT_FR);
+    CHECK_EQ(hid_to_ascii(0x14, 0), 'A');
+    CHECK_EQ(hid_to_ascii(HID_KEY_1, 0), '&');
+    keyboard_set_caps_lock(false);
+}
+
+static void test_ctrl(void) {
+    keyboard_set_layout(LAYOUT_US);
+    CHECK_EQ(hid_to_ascii(HID_KEY_A, CTRL), 0x01);
+    CHECK_EQ(hid_to_ascii(HID_KEY_Z, RCTRL | SHIFT), 0x1A);
+    CHECK_EQ(hid_to_ascii(HID_KEY_2, CTRL | SHIFT), KEY_CODE_NUL);
+    CHECK_EQ(hid_to_ascii(0x2F, CTRL), 0x1B);           // [
+    CHECK_EQ(hid_to_ascii(HID_KEY_1, CTRL), '1');       // Unchanged
+
+    // German: Ctrl follows the character, so Ctrl+Z-key is Ctrl-Y
+    keyboard_set_layout(LAYOUT_DE);
+    CHECK_EQ(hid_to_ascii(HID_KEY_Z, CTRL), 0x19);
+}
+
+// Every key and modifier combination of every layout gives a code the
+// outputs can send
+static void test_all_7bit(void) {
+    static const uint8_t mods[] = { 0, SHIFT, CTRL, CTRL | SHIFT };
+    for (int l = 0; l < LAYOUT_COUNT; l++) {
+        keyboard_set_layout((layout_id_t)l);
+        for (int caps = 0; caps < 2; caps++) {
+            keyboard_set_caps_lock(caps);
+            for (int kc = 0; kc < 256; kc++) {
+                for (size_t m = 0; m < sizeof(mods); m++) {
+                    uint8_t a = hid_to_ascii((uint8_t)kc, mods[m]);
+                    if (a >= 0x80 && a != KEY_CODE_NUL) {
+                        printf("layout %s keycode 0x%02X mod 0x%02X -> 0x%02X\n",
+                               layouts[l].name, kc, mods[m], a);
+                        host_test_failed++;
+                    }
+                }
+            }
+        }
+    }
+    keyboard_set_caps_lock(false);
+}
+
+int main(void) {
+    CHECK(layout_verify());
+    CHECK_EQ(layout_find("de"), LAYOUT_DE);
+    CHECK_EQ(layout_find("xx"), LAYOUT_COUNT);
+    test_us();
+    test_caps_lock();
+    test_ctrl();
+    test_all_7bit();
+    return host_test_failures("keymap");
+}
@@ -0,0 +1,83 @@
+/*
+ * Output pacing against the Apple II latch model
+ *
+ * Bursts of keys go through the real output queue (keyq.c), drained one
+ * key per simulated main loop pass, and every key leaving the queue
+ * strobes the latch model, as bus_output() does on the device. Each run
+ * prints one line in the form of the bench CSV, so pacing changes can be
+ * compared:
+ *
+ *   latch,<pattern>,<pace_us>,<keys>,<delivered>,<lost>,<delayed>,<max_delay_us>
+ */
+
+#include "pico/stdlib.h"
+#include "host_test.h"
+#include "keyboard.h"
+#include "keyq.h"
+#include "latch_model.h"
+#include "stats.h"
+
+#define LOOP_PASS_US   50          // Main loop period while keys are queued
+#define BURST_KEYS     40
+
+stats_counters_t stats_total;
+
+void output_key(uint8_t ascii) {
+    latch_model_strobe(ascii);
+}
+
+static const latch_model_counts_t *run(const char *pattern, uint32_t pace_us,
+                                       uint32_t keys) {
+    CHECK(latch_model_select(pattern));
+    host_time_us = 1000000;
+    keyq_flush();
+
+    // Queued in bursts as a macro or expansion would be, leaving room
+    uint32_t pushed = 0;
+    while (pushed < keys || keyq_space() < KEYQ_SIZE) {
+        while (pushed < keys && keyq_space() > 8) {
+            CHECK(keyq_push((uint8_t)('A' + pushed % 26), pace_us));
+            pushed++;
+        }
+        keyq_task();
+        host_time_us += LOOP_PASS_US;
+    }
+    host_time_us += 1000000;
+
+    const latch_model_counts_t *c = latch_model_counts();
+    printf("latch,%s,%lu,%lu,%lu,%lu,%lu,%lu\n", pattern, (unsigned long)pace_us,
+           (unsigned long)keys, (unsigned long)c->delivered, (unsigned long)c->lost,
+           (unsigned long)c->delayed, (unsigned long)c->delay_max_us);
+    CHECK_EQ(c->strobes, keys);
+    CHECK_EQ(c->delivered + c->lost + latch_model_pending(), keys);
+    return c;
+}
+
+int main(void) {
+    const latch_model_counts_t *c;
+
+    // GETLN spends 2 ms echoing each key: flat out loses most of a burst,
+    // the default pacing loses none
+    c = run("getln", 0, BURST_KEYS);
+    CHECK(c->lost > BURST_KEYS / 2);
+    c = run("getln", 2500, BURST_KEYS);
+    CHECK_EQ(c->lost, 0);
+    c = run("getln", 25000, BURST_KEYS);
+    CHECK_EQ(c->lost, 0);
+    CHECK_EQ(c->delayed, 0);
+
+    // A game reading once per frame needs keys at least a frame apart
+    c = run("game", 5000, BURST_KEYS);
+    CHECK(c->lost > 0);
+    c = run("game", 17000, BURST_KEYS);
+    CHECK_EQ(c->lost, 0);
+
+    // A BASIC program away for 90 ms of every 100 ms loses keys even at
+    // the default pacing; the figures are the benchmark
+    c = run("basic", 25000, BURST_KEYS);
+    CHECK(c->lost > 0);
+    c = run("basic", 100000, BURST_KEYS);
+    CHECK_EQ(c->lost, 0);
+
+    return host_test_failures("latch");
+}
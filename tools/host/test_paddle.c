@@ -0,0 +1,166 @@
+/*
+ * Paddle timing: PREAD against the PIO program, cycle by cycle
+ *
+ * paddle_model_check() compares pulse ends with closed-form bounds on the
+ * sample times. This test does not use those bounds. It steps the 6502
+ * through PREAD, with the stretched 65th cycle of each scan line, and
+ * interprets paddle.pio instruction by instruction behind a two-stage
+ * input synchroniser. PREAD must then return every value 0-255 for every:
+ *
+ *   - position of the trigger cycle within the scan line
+ *   - point within the trigger cycle where /C07X falls (the strobe lasts
+ *     half a cycle)
+ *   - phase of the state machine clock against the trigger
+ *
+ * PREAD samples PDLn at the end of the read cycle of LDA PADDL0,X.
+ */
+
+#include <stdbool.h>
+
+#include "host_test.h"
+#include "paddle_model.h"
+
+#define TICK_PS         69841       // 14.31818 MHz
+#define CYCLE_TICKS     14
+#define LINE_CYCLES     65
+#define STROBE_TICKS    7           // /C07X low for phi0 of the access
+#define PIO_PHASES      4
+
+// paddle.pio, in order
+typedef enum {
+    OP_WAIT_HIGH,       // wait 1 pin 0
+    OP_WAIT_LOW,        // wait 0 pin 0
+    OP_PULL,            // pull noblock
+    OP_MOV_X,           // mov x, osr
+    OP_MOV_Y,           // mov y, x
+    OP_SET_HIGH,        // set pins, 1
+    OP_JMP_Y_DEC,       // jmp y-- high
+    OP_SET_LOW,         // set pins, 0
+} op_t;
+
+// Start of CPU cycle j after the start of the trigger cycle, which is
+// cycle 'line_pos' of its scan line
+static int64_t cycle_start_ps(uint32_t line_pos, uint32_t j) {
+    uint32_t stretched = (line_pos + j) / LINE_CYCLES;
+    return (int64_t)(j * CYCLE_TICKS + stretched * 2) * TICK_PS;
+}
+
+// Run the state machine from idle with the trigger falling at trig_ps.
+// Returns when the output went high and low (end of the set cycles).
+static void run_pio(uint32_t count, int64_t period_ps, int64_t phase_ps,
+                    int64_t trig_ps, int64_t *high_ps, int64_t *low_ps) {
+    int64_t strobe_end = trig_ps + STROBE_TICKS * TICK_PS;
+    op_t pc = OP_WAIT_HIGH;
+    uint32_t osr = count, x = 0, y = 0;
+    bool sync[2] = { true, true };
+
+    // Clock edges from well before the trigger
+    int64_t edge = phase_ps - 4 * period_ps;
+    for (;;) {
+        edge += period_ps;
+        bool pin = !(edge >= trig_ps && edge < strobe_end);
+        bool seen = sync[1];
+        sync[1] = sync[0];
+        sync[0] = pin;
+
+        switch (pc) {
+        case OP_WAIT_HIGH:
+            if (seen) {
+                pc = OP_WAIT_LOW;
+            }
+            break;
+        case OP_WAIT_LOW:
+            if (!seen) {
+                pc = OP_PULL;
+            }
+            break;
+        case OP_PULL:
+            pc = OP_MOV_X;
+            break;
+        case OP_MOV_X:
+            x = osr;
+            pc = OP_MOV_Y;
+            break;
+        case OP_MOV_Y:
+            y = x;
+            pc = OP_SET_HIGH;
+            break;
+        case OP_SET_HIGH:
+            *high_ps = edge;
+            pc = OP_JMP_Y_DEC;
+            break;
+        case OP_JMP_Y_DEC:
+            // One cycle per pass: jumps while Y was non-zero. The y + 1
+            // passes are taken in one step.
+            edge += (int64_t)y * period_ps;
+            y = 0;
+            pc = OP_SET_LOW;
+            break;
+        case OP_SET_LOW:
+            *low_ps = edge;
+            return;
+        }
+    }
+}
+
+// Value PREAD returns, and the closest any sample came to the output edge
+static uint32_t run_pread(uint32_t line_pos, int64_t high_ps, int64_t low_ps,
+                          int64_t *margin_ps) {
+    uint32_t y = 0;
+    for (;;) {
+        // Read cycle of the n-th LDA PADDL0,X is 10 + 11n cycles after the
+        // trigger cycle; the data is taken at its end
+        int64_t sample = cycle_start_ps(line_pos, 10 + 11 * y + 1);
+        int64_t m = sample >= low_ps ? sample - low_ps : low_ps - sample;
+        if (m < *margin_ps) {
+            *margin_ps = m;
+        }
+        if (!(sample >= high_ps && sample < low_ps)) {
+            return y;
+        }
+        if (++y == 256) {
+            return 255;     // BNE falls through, DEY
+        }
+    }
+}
+
+static void check_clock(uint32_t sys_hz) {
+    uint32_t counts[PADDLE_VALUES];
+    paddle_model_counts(sys_hz, counts);
+
+    int64_t closed_worst;
+    uint32_t closed_value;
+    CHECK_EQ(paddle_model_check(sys_hz, counts, &closed_worst, &closed_value), 0);
+
+    int64_t period_ps = 1000000000000ll / sys_hz;
+    int64_t worst = INT64_MAX;
+    uint32_t wrong = 0;
+    for (uint32_t v = 0; v < PADDLE_VALUES; v++) {
+        for (uint32_t line_pos = 0; line_pos < LINE_CYCLES; line_pos++) {
+            for (uint32_t t = 0; t < CYCLE_TICKS; t++) {
+                int64_t trig = (int64_t)t * TICK_PS;
+                for (int p = 0; p < PIO_PHASES; p++) {
+                    int64_t high = 0, low = 0;
+                    run_pio(counts[v], period_ps, period_ps * p / PIO_PHASES, trig,
+                            &high, &low);
+                    uint32_t got = run_pread(line_pos, high, low, &worst);
+                    if (got != v && wrong++ < 5) {
+                        printf("%lu Hz: value %lu read %lu (line pos %lu, tick %lu, "
+                               "phase %d)\n", (unsigned long)sys_hz, (unsigned long)v,
+                               (unsigned long)got, (unsigned long)line_pos,
+                               (unsigned long)t, p);
+                    }
+                }
+            }
+        }
+    }
+    CHECK_EQ(wrong, 0);
+    printf("paddle,%lu,worst_margin_ns=%ld,closed_form_ns=%ld\n", (unsigned long)sys_hz,
+           (long)(worst / 1000), (long)(closed_worst / 1000));
+}
+
+int main(void) {
+    check_clock(125000000);
+    check_clock(133000000);
+    return host_test_failures("paddle");
+}
@@ -0,0 +1,104 @@
+# Static memory report and budget check, run after linking:
+#
+#   cmake -DELF=<file.elf> -DNM=<nm> [-DRAM_BUDGET=<bytes>]
+#         [-DFLASH_BUDGET=<bytes>] [-DSYMBOL_BUDGET=<bytes>]
+#         [-DREPORT=<file>] -P mem_budget.cmake
+#
+# Symbols are classified by their nm type:
+#   b B        .bss          RAM only
+#   d D        .data         RAM, plus its initial image in flash
+#   t T r R    code, rodata  flash
+# The full per-symbol list goes to REPORT (default <ELF>.mem.txt), the ten
+# largest RAM symbols to the build log. Exceeding a budget (0 = none)
+# fails the build.
+
+if(NOT ELF OR NOT NM)
+    message(FATAL_ERROR "mem_budget: ELF and NM must be set")
+endif()
+foreach(var RAM_BUDGET FLASH_BUDGET SYMBOL_BUDGET)
+    if(NOT ${var})
+        set(${var} 0)
+    endif()
+endforeach()
+if(NOT REPORT)
+    set(REPORT "${ELF}.mem.txt")
+endif()
+
+execute_process(
+    COMMAND ${NM} --print-size --size-sort --reverse-sort --radix=d "${ELF}"
+    OUTPUT_VARIABLE nm_out
+    RESULT_VARIABLE nm_result
+)
+if(NOT nm_result EQUAL 0)
+    message(FATAL_ERROR "mem_budget: ${NM} failed on ${ELF}")
+endif()
+
+string(REPLACE "\n" ";" lines "${nm_out}")
+
+set(ram_total 0)
+set(flash_total 0)
+set(ram_lines "")
+set(flash_lines "")
+set(largest_ram_name "")
+set(largest_ram_size 0)
+
+foreach(line IN LISTS lines)
+    if(NOT line MATCHES "^[0-9]+ ([0-9]+) ([A-Za-z]) (.+)$")
+        continue()
+    endif()
+    math(EXPR size "${CMAKE_MATCH_1}")
+    set(type "${CMAKE_MATCH_2}")
+    set(name "${CMAKE_MATCH_3}")
+
+    if(type MATCHES "^[bBdD]$")
+        math(EXPR ram_total "${ram_total} + ${size}")
+        list(APPEND ram_lines "${size}\t${type}\t${name}")
+        if(size GREATER largest_ram_size)
+            set(largest_ram_size ${size})
+            set(largest_ram_name "${name}")
+        endif()
+    endif()
+    if(type MATCHES "^[tTrRdD]$")
+        math(EXPR flash_total "${flash_total} + ${size}")
+        list(APPEND flash_lines "${size}\t${type}\t${name}")
+    endif()
+endforeach()
+
+# nm already sorted by size, largest first
+string(REPLACE ";" "\n" ram_text "${ram_lines}")
+string(REPLACE ";" "\n" flash_text "${flash_lines}")
+file(WRITE "${REPORT}"
+    "RAM ${ram_total} bytes (budget ${RAM_BUDGET})\n${ram_text}\n\n"
+    "Flash ${flash_total} bytes (budget ${FLASH_BUDGET})\n${flash_text}\n")
+
+message(STATUS "RAM   ${ram_total} bytes (budget ${RAM_BUDGET}), flash ${flash_total} bytes (budget ${FLASH_BUDGET})")
+message(STATUS "Largest RAM symbols (full list in ${REPORT}):")
+list(LENGTH ram_lines ram_count)
+if(ram_count GREATER 10)
+    set(ram_count 10)
+endif()
+if(ram_count GREATER 0)
+    math(EXPR last "${ram_count} - 1")
+    foreach(i RANGE ${last})
+        list(GET ram_lines ${i} entry)
+        string(REPLACE "\t" "  " entry "${entry}")
+        message(STATUS "  ${entry}")
+    endforeach()
+endif()
+
+set(failed FALSE)
+if(RAM_BUDGET GREATER 0 AND ram_total GREATER RAM_BUDGET)
+    message(SEND_ERROR "RAM use ${ram_total} exceeds budget ${RAM_BUDGET}")
+    set(failed TRUE)
+endif()
+if(FLASH_BUDGET GREATER 0 AND flash_total GREATER FLASH_BUDGET)
+    message(SEND_ERROR "Flash use ${flash_total} exceeds budget ${FLASH_BUDGET}")
+    set(failed TRUE)
+endif()
+if(SYMBOL_BUDGET GREATER 0 AND largest_ram_size GREATER SYMBOL_BUDGET)
+    message(SEND_ERROR "${largest_ram_name} (${largest_ram_size} bytes) exceeds per-symbol budget ${SYMBOL_BUDGET}")
+    set(failed TRUE)
+endif()
+if(failed)
+    message(FATAL_ERROR "Memory budget exceeded")
+endif()
@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""
+Replay captured USB keyboard traffic through the SB Mini II firmware.
+
+Extracts interrupt-IN HID reports from a Linux usbmon capture and converts
+them into the firmware's replay commands ("r <delta_us> <hex>"). Accepted
+inputs:
+
+  - pcap / pcapng captured from a usbmonN interface (Wireshark, tcpdump)
+  - usbmon text from /sys/kernel/debug/usb/usbmon/<bus>u
+  - a plain dump with one "<time_us> <16 hex digits>" report per line
+
+Without --port the commands are written to stdout. With --port (requires
+pyserial) they are uploaded, the replay is started and the firmware's
+output is echoed until the "done" summary line arrives.
+
+Examples:
+  usbmon_replay.py capture.pcapng --device 3 > session.txt
+  usbmon_replay.py capture.pcapng --port /dev/ttyUSB0 --speed 10 --mute
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+REPORT_LEN = 8
+
+LINKTYPE_USB_LINUX = 189          # 48-byte usbmon header
+LINKTYPE_USB_LINUX_MMAPPED = 220  # 64-byte usbmon header
+
+XFER_INTERRUPT = 1
+
+
+def parse_usbmon_packet(pkt, header_len):
+    """Return (time_us, devnum, epnum, data) for an interrupt-IN completion."""
+    if len(pkt) < header_len:
+        return None
+    (_id, ev_type, xfer_type, epnum, devnum, _bus, _fsetup, _fdata,
+     ts_sec, ts_usec, status, _length, len_cap) = struct.unpack_from(
+        "<QBBBBHbbqiiII", pkt, 0)
+    if ev_type != ord("C") or xfer_type != XFER_INTERRUPT:
+        return None
+    if not epnum & 0x80 or status != 0:
+        return None
+    data = pkt[header_len:header_len + len_cap]
+    return ts_sec * 1000000 + ts_usec, devnum, epnum & 0x7F, bytes(data)
+
+
+def read_pcap(buf):
+    magic = struct.unpack_from("<I", buf, 0)[0]
+    if magic not in (0xA1B2C3D4, 0xA1B23C4D):
+        raise ValueError("big-endian pcap files are not supported")
+    linktype = struct.unpack_from("<I", buf, 20)[0]
+    header_len = 64 if linktype == LINKTYPE_USB_LINUX_MMAPPED else 48
+    if linktype not in (LINKTYPE_USB_LINUX, LINKTYPE_USB_LINUX_MMAPPED):
+        raise ValueError("pcap link type %d is not usbmon" % linktype)
+
+    off = 24
+    while off + 16 <= len(buf):
+        incl_len = struct.unpack_from("<I", buf, off + 8)[0]
+        pkt = buf[off + 16:off + 16 + incl_len]
+        off += 16 + incl_len
+        rec = parse_usbmon_packet(pkt, header_len)
+        if rec:
+            yield rec
+
+
+def read_pcapng(buf):
+    header_lens = {}
+    off = 0
+    while off + 12 <= len(buf):
+        block_type, block_len = struct.unpack_from("<II", buf, off)
+        if block_len < 12:
+            break
+        body = buf[off + 8:off + block_len - 4]
+        if block_type == 0x00000001:  # Interface Description Block
+            linktype = struct.unpack_from("<H", body, 0)[0]
+            if linktype in (LINKTYPE_USB_LINUX, LINKTYPE_USB_LINUX_MMAPPED):
+                header_lens[len(header_lens)] = (
+                    64 if linktype == LINKTYPE_USB_LINUX_MMAPPED else 48)
+            else:
+                header_lens[len(header_lens)] = None
+        elif block_type == 0x00000006:  # Enhanced Packet Block
+            if_id, _ts_hi, _ts_lo, cap_len = struct.unpack_from("<IIII", body, 0)
+            header_len = header_lens.get(if_id)
+            if header_len:
+                rec = parse_usbmon_packet(body[20:20 + cap_len], header_len)
+                if rec:
+                    yield rec
+        off += block_len
+
+
+def read_text(lines):
+    for line in lines:
+        fields = line.split()
+        if len(fields) == 2:
+            # Plain dump: <time_us> <hex>
+            yield int(fields[0]), None, None, bytes.fromhex(fields[1])
+        elif len(fields) > 5 and fields[2] == "C" and fields[3].startswith("Ii:"):
+            # usbmon text: tag time C Ii:bus:dev:ep status len = data...
+            _, _bus, dev, ep = fields[3].split(":")
+            if not fields[4].startswith("0") or "=" not in fields:
+                continue
+            data = "".join(fields[fields.index("=") + 1:])
+            yield int(fields[1]), int(dev), int(ep), bytes.fromhex(data)
+
+
+def load_reports(path):
+    with open(path, "rb") as f:
+        buf = f.read()
+    magic = struct.unpack_from("<I", buf, 0)[0] if len(buf) >= 4 else 0
+    if magic == 0x0A0D0D0A:
+        return read_pcapng(buf)
+    if magic in (0xA1B2C3D4, 0xA1B23C4D, 0xD4C3B2A1, 0x4D3CB2A1):
+        return read_pcap(buf)
+    return read_text(buf.decode("ascii", "replace").splitlines())
+
+
+def replay_commands(path, device, endpoint):
+    yield "replay clear"
+    last_us = None
+    for time_us, dev, ep, data in load_reports(path):
+        if device is not None and dev is not None and dev != device:
+            continue
+        if endpoint is not None and ep is not None and ep != endpoint:
+            continue
+        if len(data) < REPORT_LEN:
+            continue
+        delta = 0 if last_us is None else max(0, time_us - last_us)
+        last_us = time_us
+        yield "r %d %s" % (delta, data[:REPORT_LEN].hex().upper())
+
+
+def run_on_device(commands, port, speed, mute):
+    import serial  # pyserial
+
+    with serial.Serial(port, 115200, timeout=0.1) as ser:
+        for cmd in commands:
+            ser.write((cmd + "\r").encode())
+            # Keep within the console's line buffer and the UART's pace
+            ser.flush()
+            time.sleep(0.005)
+        ser.write(("replay run %d%s\r" % (speed, " mute" if mute else "")).encode())
+
+        while True:
+            line = ser.readline().decode("ascii", "replace").rstrip()
+            if line:
+                print(line)
+            if line.startswith("done "):
+                break
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("capture", help="pcap, pcapng, usbmon text or plain dump")
+    ap.add_argument("--device", type=int, help="only use this USB device number")
+    ap.add_argument("--endpoint", type=int, help="only use this IN endpoint number")
+    ap.add_argument("--port", help="serial port of the firmware's debug UART")
+    ap.add_argument("--speed", type=int, default=1,
+                    help="1 = original timing, N = N times faster, 0 = flat out")
+    ap.add_argument("--mute", action="store_true",
+                    help="do not drive the Apple II bus during the replay")
+    args = ap.parse_args()
+
+    commands = replay_commands(args.capture, args.device, args.endpoint)
+    if args.port:
+        run_on_device(commands, args.port, args.speed, args.mute)
+    else:
+        for cmd in commands:
+            print(cmd)
+
+
+if __name__ == "__main__":
+    sys.exit(main())